@@ -1,4 +1,5 @@
 #include "config_manager.h"
+#include "wakeup.h"
 #include <algorithm>
 #include <cstdlib>
 #include <filesystem>
@@ -209,6 +210,7 @@ bool ConfigManager::createDefaultConfig(const std::string &config_file)
     config["editor"]["tab_size"] = 4;
     config["editor"]["line_numbers"] = true;
     config["editor"]["cursor_style"] = "auto";
+    config["editor"]["renderer"] = "curses";
     config["syntax"]["highlighting"] = "viewport"; // Changed to string
 
     std::ofstream file(config_file);
@@ -269,6 +271,11 @@ bool ConfigManager::loadConfig()
         editor_config_.cursor_style =
             config["editor"]["cursor_style"].as<std::string>();
       }
+      if (config["editor"]["renderer"])
+      {
+        editor_config_.renderer =
+            config["editor"]["renderer"].as<std::string>();
+      }
     }
 
     // Load syntax section
@@ -307,6 +314,7 @@ bool ConfigManager::saveConfig()
   config["editor"]["tab_size"] = editor_config_.tab_size;
   config["editor"]["line_numbers"] = editor_config_.line_numbers;
   config["editor"]["cursor_style"] = editor_config_.cursor_style;
+  config["editor"]["renderer"] = editor_config_.renderer;
   config["syntax"]["highlighting"] =
       syntaxModeToString(syntax_config_.highlighting);
 
@@ -359,6 +367,7 @@ void ConfigManager::handleFileChange()
     callback();
   }
   reload_pending_.store(true);
+  Wakeup::notify(); // The main loop may be asleep until the next key
   // std::cerr << "Configuration hot reload complete." << std::endl;
 }
 
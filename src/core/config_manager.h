@@ -30,6 +30,7 @@ struct EditorConfig
   int tab_size = 4;
   bool line_numbers = true;
   std::string cursor_style = "auto"; // auto, block, bar, underline
+  std::string renderer = "curses";   // curses, truecolor
 };
 
 // Syntax configuration structure
@@ -65,6 +66,7 @@ public:
   static int getTabSize() { return editor_config_.tab_size; }
   static bool getLineNumbers() { return editor_config_.line_numbers; }
   static std::string getCursorStyle() { return editor_config_.cursor_style; }
+  static std::string getRenderer() { return editor_config_.renderer; }
   static SyntaxMode getSyntaxMode() { return syntax_config_.highlighting; }
 
   // NEW: Configuration setters (also saves to file)
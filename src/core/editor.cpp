@@ -231,37 +231,13 @@ bool Editor::isPositionSelected(int line, int col)
   }
 }
 
-void Editor::positionCursor()
-{
-  int rows, cols;
-  getmaxyx(stdscr, rows, cols);
-
-  int screenRow = cursorLine - viewportTop;
-  if (screenRow >= 0 && screenRow < viewportHeight)
-  {
-    bool show_line_numbers = ConfigManager::getLineNumbers();
-    int lineNumWidth =
-        show_line_numbers ? std::to_string(buffer.getLineCount()).length() : 0;
-    int contentStartCol = show_line_numbers ? (lineNumWidth + 3) : 0;
-    int screenCol = contentStartCol + cursorCol - viewportLeft;
-
-    if (screenCol >= contentStartCol && screenCol < cols)
-    {
-      move(screenRow, screenCol);
-    }
-    else
-    {
-      move(screenRow, contentStartCol);
-    }
-  }
-  // REMOVED: All #ifdef _WIN32 refresh() calls
-}
+void Editor::positionCursor() { renderer.positionCursor(gatherFrameState()); }
 
 bool Editor::mouseToFilePos(int mouseRow, int mouseCol, int &fileRow,
                             int &fileCol)
 {
   int rows, cols;
-  getmaxyx(stdscr, rows, cols);
+  screenSize(rows, cols);
 
   if (mouseRow >= rows - 1)
     return false;
@@ -308,7 +284,7 @@ void Editor::updateCursorAndViewport(int newLine, int newCol)
   }
 
   int rows, cols;
-  getmaxyx(stdscr, rows, cols);
+  screenSize(rows, cols);
   bool show_line_numbers = ConfigManager::getLineNumbers();
   int lineNumWidth =
       show_line_numbers ? std::to_string(buffer.getLineCount()).length() : 0;
@@ -343,15 +319,7 @@ void Editor::display()
       return;
   }
 
-  int rows, cols;
-  getmaxyx(stdscr, rows, cols);
-  viewportHeight = rows - 1;
-
-  bool show_line_numbers = ConfigManager::getLineNumbers();
-  int lineNumWidth =
-      show_line_numbers ? std::to_string(buffer.getLineCount()).length() : 0;
-  int contentStartCol = show_line_numbers ? (lineNumWidth + 3) : 0;
-  int contentWidth = cols - contentStartCol;
+  viewportHeight = renderer.backend().rows() - 1;
 
   int endLine = std::min(viewportTop + viewportHeight, buffer.getLineCount());
 
@@ -359,283 +327,76 @@ void Editor::display()
   if (syntaxHighlighter)
   {
     syntaxHighlighter->markViewportLines(viewportTop, endLine - 1);
+    // One query for every visible line; getHighlightSpans() then hits cache
+    syntaxHighlighter->highlightViewport(buffer, viewportTop, endLine - 1);
   }
 
-  // Pre-compute selection (unchanged)
-  bool hasActiveSelection = (hasSelection || isSelecting);
-  int sel_start_line = -1, sel_start_col = -1;
-  int sel_end_line = -1, sel_end_col = -1;
-
-  if (hasActiveSelection)
-  {
-    auto [start, end] = getNormalizedSelection();
-    sel_start_line = start.first;
-    sel_start_col = start.second;
-    sel_end_line = end.first;
-    sel_end_col = end.second;
-  }
-
-  int currentTabSize = ConfigManager::getTabSize();
-
-  // OPTIMIZATION: Batch render - minimize attribute changes
-  for (int i = viewportTop; i < endLine; i++)
-  {
-    int screenRow = i - viewportTop;
-    bool isCurrentLine = (cursorLine == i);
-
-    move(screenRow, 0);
-    attrset(COLOR_PAIR(0));
-
-    // Render line numbers
-    if (show_line_numbers)
-    {
-      int ln_colorPair = isCurrentLine ? 3 : 2;
-      attron(COLOR_PAIR(ln_colorPair));
-      printw("%*d ", lineNumWidth, i + 1);
-      attroff(COLOR_PAIR(ln_colorPair));
-
-      attron(COLOR_PAIR(4));
-      addch(' ');
-      attroff(COLOR_PAIR(4));
-      addch(' ');
-    }
-
-    // Get line content
-    std::string expandedLine = expandTabs(buffer.getLine(i), currentTabSize);
-
-    // OPTIMIZATION: Get highlighting spans (cached if available)
-    std::vector<ColorSpan> currentLineSpans;
-    if (syntaxHighlighter)
-    {
-      try
-      {
-        currentLineSpans =
-            syntaxHighlighter->getHighlightSpans(expandedLine, i, buffer);
-      }
-      catch (...)
-      {
-        currentLineSpans.clear();
-      }
-    }
-
-    // Render line content (unchanged logic, but faster due to cached spans)
-    bool lineHasSelection =
-        hasActiveSelection && i >= sel_start_line && i <= sel_end_line;
-    int current_span_idx = 0;
-    int num_spans = currentLineSpans.size();
-
-    for (int screenCol = 0; screenCol < contentWidth; screenCol++)
-    {
-      int fileCol = viewportLeft + screenCol;
-      bool charExists =
-          (fileCol >= 0 && fileCol < static_cast<int>(expandedLine.length()));
-      char ch = charExists ? expandedLine[fileCol] : ' ';
-
-      if (charExists && (ch < 32 || ch > 126))
-        ch = ' ';
-
-      // Selection check
-      bool isSelected = false;
-      if (lineHasSelection && charExists)
-      {
-        if (sel_start_line == sel_end_line)
-        {
-          isSelected = (fileCol >= sel_start_col && fileCol < sel_end_col);
-        }
-        else if (i == sel_start_line)
-        {
-          isSelected = (fileCol >= sel_start_col);
-        }
-        else if (i == sel_end_line)
-        {
-          isSelected = (fileCol < sel_end_col);
-        }
-        else
-        {
-          isSelected = true;
-        }
-      }
-
-      if (isSelected)
-      {
-        attron(COLOR_PAIR(14) | A_REVERSE);
-        addch(ch);
-        attroff(COLOR_PAIR(14) | A_REVERSE);
-      }
-      else
-      {
-        bool colorApplied = false;
-
-        if (charExists && num_spans > 0)
-        {
-          while (current_span_idx < num_spans &&
-                 currentLineSpans[current_span_idx].end <= fileCol)
-          {
-            current_span_idx++;
-          }
-
-          if (current_span_idx < num_spans)
-          {
-            const auto &span = currentLineSpans[current_span_idx];
-            if (fileCol >= span.start && fileCol < span.end)
-            {
-              if (span.colorPair >= 0 && span.colorPair < COLOR_PAIRS)
-              {
-                attron(COLOR_PAIR(span.colorPair));
-                if (span.attribute != 0)
-                  attron(span.attribute);
-                addch(ch);
-                if (span.attribute != 0)
-                  attroff(span.attribute);
-                attroff(COLOR_PAIR(span.colorPair));
-                colorApplied = true;
-              }
-            }
-          }
-        }
+  renderer.render(gatherFrameState(), buffer, syntaxHighlighter);
+}
 
-        if (!colorApplied)
-        {
-          attrset(COLOR_PAIR(0));
-          addch(ch);
-        }
-      }
-    }
+bool Editor::refreshHighlights()
+{
+  if (!syntaxHighlighter)
+    return false;
 
-    attrset(COLOR_PAIR(0));
-    clrtoeol();
-  }
+  if (!syntaxHighlighter->adoptBackgroundParse())
+    return false;
 
-  // Clear remaining lines
-  attrset(COLOR_PAIR(0));
-  for (int i = endLine - viewportTop; i < viewportHeight; i++)
-  {
-    move(i, 0);
-    clrtoeol();
-  }
+  int endLine = std::min(viewportTop + viewportHeight, buffer.getLineCount());
+  syntaxHighlighter->highlightViewport(buffer, viewportTop, endLine - 1);
 
-  drawStatusBar();
-  positionCursor();
+  // Only visible rows whose spans changed differ from the last frame
+  return renderer.render(gatherFrameState(), buffer, syntaxHighlighter) > 0;
 }
 
-void Editor::drawStatusBar()
+void Editor::prefetchHighlights()
 {
-  int rows, cols;
-  getmaxyx(stdscr, rows, cols);
-  int statusRow = rows - 1;
-
-  move(statusRow, 0);
-  attrset(COLOR_PAIR(STATUS_BAR));
-  clrtoeol();
-
-  move(statusRow, 0);
-  attron(COLOR_PAIR(STATUS_BAR));
+  if (syntaxHighlighter)
+    syntaxHighlighter->prefetchHighlights(buffer);
+}
 
-  // Show filename
-  attron(COLOR_PAIR(STATUS_BAR_CYAN) | A_BOLD);
-  if (filename.empty())
-  {
-    printw("[No Name]");
-  }
-  else
-  {
-    size_t lastSlash = filename.find_last_of("/\\");
-    std::string displayName = (lastSlash != std::string::npos)
-                                  ? filename.substr(lastSlash + 1)
-                                  : filename;
-    printw("%s", displayName.c_str());
-  }
-  attroff(COLOR_PAIR(STATUS_BAR_CYAN) | A_BOLD);
+Renderer::FrameState Editor::gatherFrameState()
+{
+  Renderer::FrameState state;
 
-  // Show modified indicator
-  if (isModified)
-  {
-    attron(COLOR_PAIR(STATUS_BAR_ACTIVE) | A_BOLD);
-    printw(" [+]");
-    attroff(COLOR_PAIR(STATUS_BAR_ACTIVE) | A_BOLD);
-  }
+  state.viewport.top = viewportTop;
+  state.viewport.left = viewportLeft;
+  state.viewport.height = viewportHeight;
+  state.viewport.width = renderer.backend().cols();
+  state.cursor.line = cursorLine;
+  state.cursor.col = cursorCol;
+  state.line_count = buffer.getLineCount();
 
-  // Show file extension
-  std::string ext = getFileExtension();
-  if (!ext.empty())
-  {
-    attron(COLOR_PAIR(STATUS_BAR_ACTIVE));
-    printw(" [%s]", ext.c_str());
-    attroff(COLOR_PAIR(STATUS_BAR_ACTIVE));
-  }
+  state.show_line_numbers = ConfigManager::getLineNumbers();
+  state.line_num_width = state.show_line_numbers
+                             ? std::to_string(state.line_count).length()
+                             : 0;
+  state.viewport.content_start_col =
+      state.show_line_numbers ? (state.line_num_width + 3) : 0;
+  state.tab_size = ConfigManager::getTabSize();
 
-  // Right section with position info
-  char rightSection[256];
-  if (hasSelection)
+  // Pre-compute selection
+  state.has_selection = (hasSelection || isSelecting);
+  if (state.has_selection)
   {
     auto [start, end] = getNormalizedSelection();
-    int startL = start.first, startC = start.second;
-    int endL = end.first, endC = end.second;
-
-    if (startL == endL)
-    {
-      int selectionSize = endC - startC;
-      snprintf(rightSection, sizeof(rightSection),
-               "[%d chars] %d:%d %d/%d %d%% ", selectionSize, cursorLine + 1,
-               cursorCol + 1, cursorLine + 1, buffer.getLineCount(),
-               buffer.getLineCount() == 0
-                   ? 0
-                   : ((cursorLine + 1) * 100 / buffer.getLineCount()));
-    }
-    else
-    {
-      int lineCount = endL - startL + 1;
-      snprintf(rightSection, sizeof(rightSection),
-               "[%d lines] %d:%d %d/%d %d%% ", lineCount, cursorLine + 1,
-               cursorCol + 1, cursorLine + 1, buffer.getLineCount(),
-               buffer.getLineCount() == 0
-                   ? 0
-                   : ((cursorLine + 1) * 100 / buffer.getLineCount()));
-    }
-  }
-  else
-  {
-    snprintf(rightSection, sizeof(rightSection), "%d:%d %d/%d %d%% ",
-             cursorLine + 1, cursorCol + 1, cursorLine + 1,
-             buffer.getLineCount(),
-             buffer.getLineCount() == 0
-                 ? 0
-                 : ((cursorLine + 1) * 100 / buffer.getLineCount()));
+    state.selection_start_line = start.first;
+    state.selection_start_col = start.second;
+    state.selection_end_line = end.first;
+    state.selection_end_col = end.second;
   }
+  state.show_selection_size = hasSelection;
 
-  int rightLen = strlen(rightSection);
-  int currentPos = getcurx(stdscr);
-  int rightStart = cols - rightLen;
-
-  if (rightStart <= currentPos)
-  {
-    rightStart = currentPos + 2;
-  }
-
-  // Fill middle space
-  attron(COLOR_PAIR(STATUS_BAR));
-  for (int i = currentPos; i < rightStart && i < cols; i++)
-  {
-    move(statusRow, i);
-    addch(' ');
-  }
-
-  // Right section
-  if (rightStart < cols)
-  {
-    move(statusRow, rightStart);
-    attron(COLOR_PAIR(STATUS_BAR_YELLOW) | A_BOLD);
-    printw("%s", rightSection);
-    attroff(COLOR_PAIR(STATUS_BAR_YELLOW) | A_BOLD);
-  }
-
-  attroff(COLOR_PAIR(STATUS_BAR));
+  state.filename = filename;
+  state.extension = getFileExtension();
+  state.is_modified = isModified;
+  return state;
 }
 
 void Editor::handleResize()
 {
   int rows, cols;
-  getmaxyx(stdscr, rows, cols);
+  screenSize(rows, cols);
   viewportHeight = rows - 1;
 
   if (cursorLine >= viewportTop + viewportHeight)
@@ -647,10 +408,10 @@ void Editor::handleResize()
     viewportTop = 0;
   }
   clear();
+  invalidateFrame();
   display();
 
-  wnoutrefresh(stdscr); // Mark stdscr as ready
-  doupdate();           // Execute the single, clean flush
+  renderer.backend().flush(); // Single, clean flush
 }
 
 void Editor::handleMouse(MEVENT &event)
@@ -812,7 +573,7 @@ void Editor::moveCursorLeft()
     }
 
     int rows, cols;
-    getmaxyx(stdscr, rows, cols);
+    screenSize(rows, cols);
     bool show_line_numbers = ConfigManager::getLineNumbers();
     int lineNumWidth =
         show_line_numbers ? std::to_string(buffer.getLineCount()).length() : 0;
@@ -848,7 +609,7 @@ void Editor::moveCursorRight()
     }
 
     int rows, cols;
-    getmaxyx(stdscr, rows, cols);
+    screenSize(rows, cols);
     bool show_line_numbers = ConfigManager::getLineNumbers();
     int lineNumWidth =
         show_line_numbers ? std::to_string(buffer.getLineCount()).length() : 0;
@@ -909,7 +670,7 @@ void Editor::moveCursorToLineEnd()
   cursorCol = static_cast<int>(expandedLine.length());
 
   int rows, cols;
-  getmaxyx(stdscr, rows, cols);
+  screenSize(rows, cols);
   bool show_line_numbers = ConfigManager::getLineNumbers();
   int lineNumWidth =
       show_line_numbers ? std::to_string(buffer.getLineCount()).length() : 0;
@@ -1174,7 +935,7 @@ void Editor::insertChar(char ch)
 
     // Update viewport
     int rows, cols;
-    getmaxyx(stdscr, rows, cols);
+    screenSize(rows, cols);
     bool show_line_numbers = ConfigManager::getLineNumbers();
     int lineNumWidth =
         show_line_numbers ? std::to_string(buffer.getLineCount()).length() : 0;
@@ -1241,7 +1002,7 @@ void Editor::insertChar(char ch)
     markModified();
 
     int rows, cols;
-    getmaxyx(stdscr, rows, cols);
+    screenSize(rows, cols);
     int lineNumWidth = std::to_string(buffer.getLineCount()).length();
     int contentWidth = cols - lineNumWidth - 3;
     if (contentWidth > 0 && cursorCol >= viewportLeft + contentWidth)
@@ -1275,8 +1036,7 @@ void Editor::insertNewline()
           0); // NEW position
 
       // Invalidate from split point onwards
-      syntaxHighlighter->invalidateLineRange(cursorLine - 1,
-                                             buffer.getLineCount() - 1);
+      syntaxHighlighter->invalidateLineRange(cursorLine - 1, cursorLine);
     }
 
     if (cursorLine >= viewportTop + viewportHeight)
@@ -1323,8 +1083,7 @@ void Editor::insertNewline()
       syntaxHighlighter->updateTreeAfterEdit(buffer, byte_pos, 0, 1,
                                              cursorLine - 1, 0, cursorLine - 1,
                                              0, cursorLine, 0);
-      syntaxHighlighter->invalidateLineRange(cursorLine - 1,
-                                             buffer.getLineCount() - 1);
+      syntaxHighlighter->invalidateLineRange(cursorLine - 1, cursorLine);
     }
 
     if (cursorLine >= viewportTop + viewportHeight)
@@ -1373,8 +1132,7 @@ void Editor::deleteChar()
             buffer, byte_pos, 1, 0, cursorLine, (uint32_t)line.length(),
             cursorLine + 1, 0, cursorLine, (uint32_t)line.length());
 
-        syntaxHighlighter->invalidateLineRange(cursorLine,
-                                               buffer.getLineCount() - 1);
+        syntaxHighlighter->invalidateLineRange(cursorLine, cursorLine);
       }
     }
 
@@ -1435,8 +1193,7 @@ void Editor::deleteChar()
         syntaxHighlighter->updateTreeAfterEdit(
             buffer, byte_pos, 1, 0, cursorLine, (uint32_t)line.length(),
             cursorLine + 1, 0, cursorLine, (uint32_t)line.length());
-        syntaxHighlighter->invalidateLineRange(cursorLine,
-                                               buffer.getLineCount() - 1);
+        syntaxHighlighter->invalidateLineRange(cursorLine, cursorLine);
       }
 
       markModified();
@@ -1493,8 +1250,7 @@ void Editor::backspace()
             buffer, byte_pos, 1, 0, cursorLine, cursorCol, oldCursorLine, 0,
             cursorLine, cursorCol);
 
-        syntaxHighlighter->invalidateLineRange(cursorLine,
-                                               buffer.getLineCount() - 1);
+        syntaxHighlighter->invalidateLineRange(cursorLine, cursorLine);
       }
     }
 
@@ -1566,8 +1322,7 @@ void Editor::backspace()
         syntaxHighlighter->updateTreeAfterEdit(
             buffer, byte_pos, 1, 0, cursorLine, cursorCol, cursorLine + 1, 0,
             cursorLine, cursorCol);
-        syntaxHighlighter->invalidateLineRange(cursorLine,
-                                               buffer.getLineCount() - 1);
+        syntaxHighlighter->invalidateLineRange(cursorLine, cursorLine);
       }
 
       markModified();
@@ -1619,8 +1374,7 @@ void Editor::deleteLine()
           buffer, byte_pos, delete_bytes, 0, cursorLine, 0,
           cursorLine + (has_newline ? 1 : 0),
           has_newline ? 0 : (uint32_t)line_length, cursorLine, 0);
-      syntaxHighlighter->invalidateLineRange(cursorLine,
-                                             buffer.getLineCount() - 1);
+      syntaxHighlighter->invalidateLineRange(cursorLine, cursorLine);
     }
 
     if (cursorLine >= buffer.getLineCount())
@@ -1692,8 +1446,7 @@ void Editor::deleteSelection()
           buffer, start_byte, delete_bytes, 0, // Deleted bytes
           startLine, startCol, endLine, endCol, startLine, startCol);
 
-      syntaxHighlighter->invalidateLineRange(startLine,
-                                             buffer.getLineCount() - 1);
+      syntaxHighlighter->invalidateLineRange(startLine, startLine);
     }
 
     updateCursorAndViewport(startLine, startCol);
@@ -1761,8 +1514,7 @@ void Editor::deleteSelection()
       syntaxHighlighter->updateTreeAfterEdit(buffer, start_byte, delete_bytes,
                                              0, startLine, startCol, endLine,
                                              endCol, startLine, startCol);
-      syntaxHighlighter->invalidateLineRange(startLine,
-                                             buffer.getLineCount() - 1);
+      syntaxHighlighter->invalidateLineRange(startLine, startLine);
     }
 
     updateCursorAndViewport(startLine, startCol);
@@ -1799,19 +1551,9 @@ void Editor::undo()
     std::cerr << "Undoing group:\n" << group.toString() << "\n";
 #endif
 
-    // Track affected line range for incremental highlighting
-    int minAffectedLine = buffer.getLineCount();
-    int maxAffectedLine = 0;
-
     // Apply deltas in REVERSE order
     for (auto it = group.deltas.rbegin(); it != group.deltas.rend(); ++it)
     {
-      // Track which lines are affected
-      minAffectedLine =
-          std::min(minAffectedLine, std::min(it->startLine, it->preCursorLine));
-      maxAffectedLine =
-          std::max(maxAffectedLine, std::max(it->endLine, it->postCursorLine));
-
       applyDeltaReverse(*it);
 
 #ifdef DEBUG_DELTA_UNDO
@@ -1827,26 +1569,12 @@ void Editor::undo()
     // Save to redo stack
     deltaRedoStack_.push(group);
 
-    // FIXED: Incremental syntax update instead of full reparse
-    if (syntaxHighlighter)
-    {
-      // Only invalidate affected line range, not entire cache
-      syntaxHighlighter->invalidateLineRange(minAffectedLine,
-                                             buffer.getLineCount() - 1);
-
-      // Use viewport-only parsing for immediate visual update
-      syntaxHighlighter->parseViewportOnly(buffer, viewportTop);
-
-      // Schedule background full reparse (non-blocking)
-      syntaxHighlighter->scheduleBackgroundParse(buffer);
-    }
+    resyncHighlighting();
 
     isModified = true;
 
 #ifdef DEBUG_DELTA_UNDO
     EditorSnapshot afterUndo = captureSnapshot();
-    std::cerr << "Affected lines: " << minAffectedLine << " to "
-              << maxAffectedLine << "\n";
     std::cerr << "=== UNDO END ===\n\n";
 #endif
   }
@@ -1894,18 +1622,9 @@ void Editor::redo()
     std::cerr << "Redoing group:\n" << group.toString() << "\n";
 #endif
 
-    // Track affected line range
-    int minAffectedLine = buffer.getLineCount();
-    int maxAffectedLine = 0;
-
     // Apply deltas in FORWARD order
     for (const auto &delta : group.deltas)
     {
-      minAffectedLine = std::min(
-          minAffectedLine, std::min(delta.startLine, delta.preCursorLine));
-      maxAffectedLine = std::max(maxAffectedLine,
-                                 std::max(delta.endLine, delta.postCursorLine));
-
       applyDeltaForward(delta);
 
 #ifdef DEBUG_DELTA_UNDO
@@ -1921,21 +1640,12 @@ void Editor::redo()
     // Save to undo stack
     deltaUndoStack_.push(group);
 
-    // FIXED: Incremental syntax update
-    if (syntaxHighlighter)
-    {
-      syntaxHighlighter->invalidateLineRange(minAffectedLine,
-                                             buffer.getLineCount() - 1);
-      syntaxHighlighter->parseViewportOnly(buffer, viewportTop);
-      syntaxHighlighter->scheduleBackgroundParse(buffer);
-    }
+    resyncHighlighting();
 
     isModified = true;
 
 #ifdef DEBUG_DELTA_UNDO
     EditorSnapshot afterRedo = captureSnapshot();
-    std::cerr << "Affected lines: " << minAffectedLine << " to "
-              << maxAffectedLine << "\n";
     std::cerr << "=== REDO END ===\n\n";
 #endif
   }
@@ -2168,19 +1878,8 @@ void Editor::copySelection()
   if (!hasSelection && !isSelecting)
     return;
 
-  clipboard = getSelectedText();
-
-  // On Unix, also copy to system clipboard using xclip or xsel
-#ifndef _WIN32
-  FILE *pipe = popen("xclip -selection clipboard 2>/dev/null || xsel "
-                     "--clipboard --input 2>/dev/null",
-                     "w");
-  if (pipe)
-  {
-    fwrite(clipboard.c_str(), 1, clipboard.length(), pipe);
-    pclose(pipe);
-  }
-#endif
+  // Hand off to the clipboard worker; never blocks on helper processes
+  clipboard.copy(getSelectedText());
 }
 
 void Editor::cutSelection()
@@ -2194,29 +1893,9 @@ void Editor::cutSelection()
 
 void Editor::pasteFromClipboard()
 {
-  // Try to get from system clipboard first
-#ifndef _WIN32
-  FILE *pipe = popen("xclip -selection clipboard -o 2>/dev/null || xsel "
-                     "--clipboard --output 2>/dev/null",
-                     "r");
-  if (pipe)
-  {
-    char buffer_chars[4096];
-    std::string result;
-    while (fgets(buffer_chars, sizeof(buffer_chars), pipe))
-    {
-      result += buffer_chars;
-    }
-    pclose(pipe);
-
-    if (!result.empty())
-    {
-      clipboard = result;
-    }
-  }
-#endif
-
-  if (clipboard.empty())
+  // Cached system clipboard (refreshed in the background)
+  Clipboard::Text text = clipboard.paste();
+  if (text->empty())
     return;
 
   // SAVE STATE BEFORE PASTE (single undo point for entire paste)
@@ -2234,7 +1913,7 @@ void Editor::pasteFromClipboard()
   // Insert clipboard content character by character
   // Note: Each insertChar/insertNewline will NOT call saveState
   // because we already saved it above
-  for (char ch : clipboard)
+  for (char ch : *text)
   {
     if (ch == '\n')
     {
@@ -2267,8 +1946,9 @@ void Editor::initializeViewportHighlighting()
 {
   if (syntaxHighlighter)
   {
-    // Pre-parse viewport so first display() is instant
-    syntaxHighlighter->parseViewportOnly(buffer, viewportTop);
+    // Parse in the background; the first display() paints with basic
+    // colors and refreshHighlights() recolors rows as the tree lands
+    syntaxHighlighter->scheduleBackgroundParse(buffer);
   }
 }
 
@@ -2718,15 +2398,6 @@ void Editor::applyDeltaForward(const EditDelta &delta)
   validateCursorAndViewport();
   buffer.invalidateLineIndex();
 
-  // Invalidate only affected lines (not entire cache)
-  if (syntaxHighlighter)
-  {
-    int startLine = std::min(delta.startLine, delta.preCursorLine);
-    int endLine = std::max(delta.endLine, delta.postCursorLine);
-    syntaxHighlighter->invalidateLineRange(startLine,
-                                           buffer.getLineCount() - 1);
-  }
-
   isUndoRedoing = false;
 }
 
@@ -2917,34 +2588,18 @@ void Editor::saveState()
   lastEditTime = now;
 }
 
-void Editor::optimizedLineInvalidation(int startLine, int endLine)
+void Editor::resyncHighlighting()
 {
   if (!syntaxHighlighter)
   {
     return;
   }
 
-  // Only invalidate if change is significant
-  int changeSize = endLine - startLine + 1;
-
-  if (changeSize > 100)
-  {
-    // Large change: full reparse (but async)
-    syntaxHighlighter->clearAllCache();
-    syntaxHighlighter->scheduleBackgroundParse(buffer);
-  }
-  else if (changeSize > 10)
-  {
-    // Medium change: invalidate range and reparse viewport
-    syntaxHighlighter->invalidateLineRange(startLine,
-                                           buffer.getLineCount() - 1);
-    syntaxHighlighter->parseViewportOnly(buffer, viewportTop);
-  }
-  else
-  {
-    // Small change: just invalidate the affected lines
-    syntaxHighlighter->invalidateLineRange(startLine, endLine);
-  }
+  // Incremental syntax update driven by the text diff and changed ranges.
+  // Undo/redo replay deltas without describing them to the highlighter. It
+  // derives the edit from the text itself, shifts its cache accordingly, and
+  // the next reparse recolors only the rows whose syntax actually changed.
+  syntaxHighlighter->applyBufferDiff(buffer);
 }
 
 // ============================================================================
@@ -13,7 +13,9 @@
 #include "buffer.h"
 #include "editor_delta.h"
 #include "editor_validation.h"
+#include "src/features/clipboard.h"
 #include "src/features/syntax_highlighter.h"
+#include "src/ui/renderer.h"
 
 // Undo/Redo system
 struct EditorState
@@ -41,9 +43,23 @@ public:
   bool loadFile(const std::string &fname);
   bool saveFile();
   void display();
-  void drawStatusBar();
+  // Repaint visible rows recolored by a finished background parse; returns
+  // true if anything was drawn
+  bool refreshHighlights();
+  // Highlight ahead of the scroll direction while waiting for input
+  void prefetchHighlights();
   void handleResize();
   void handleMouse(MEVENT &event);
+  // The screen was cleared behind our back (theme reload); repaint every row
+  // on the next display()
+  void invalidateFrame() { renderer.invalidate(); }
+  // Draw somewhere other than stdscr (e.g. a HeadlessBackend for benchmarks)
+  void setRenderBackend(std::unique_ptr<RenderBackend> backend)
+  {
+    renderer.setBackend(std::move(backend));
+  }
+  // Send the drawn frame to the terminal
+  void flushScreen() { renderer.backend().flush(); }
 
   std::string getFilename() const { return filename; }
   std::string getFirstLine() const { return buffer.getLine(0); }
@@ -82,6 +98,7 @@ public:
   void cutSelection();
   void pasteFromClipboard();
   void selectAll();
+  void flushClipboardOutput() { clipboard.flushTerminalOutput(); }
 
   // Undo/Redo
 
@@ -158,7 +175,7 @@ private:
   int cursorCol = 0;
 
   // Clipboard
-  std::string clipboard;
+  Clipboard clipboard;
 
   // Undo/Redo
   std::chrono::steady_clock::time_point lastEditTime;
@@ -172,6 +189,16 @@ private:
   bool isModified = false;
   int tabSize = 4;
 
+  // Drawing; the editor only describes the frame
+  Renderer renderer;
+  Renderer::FrameState gatherFrameState();
+  // Size of the screen being drawn to, status bar included
+  void screenSize(int &rows, int &cols)
+  {
+    rows = renderer.backend().rows();
+    cols = renderer.backend().cols();
+  }
+
   // Private helpers
   std::string expandTabs(const std::string &line, int tabSize = 4);
   std::string getFileExtension();
@@ -187,7 +214,7 @@ private:
   std::pair<std::pair<int, int>, std::pair<int, int>> getNormalizedSelection();
 
   void notifyTreeSitterEdit(const EditDelta &delta, bool isReverse);
-  void optimizedLineInvalidation(int startLine, int endLine);
+  void resyncHighlighting();
 
   // Cursor Style
   CursorMode currentMode = NORMAL;
@@ -0,0 +1,137 @@
+// src/core/wakeup.cpp
+#include "wakeup.h"
+
+#include <iostream>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+#endif
+
+int Wakeup::read_fd_ = -1;
+int Wakeup::write_fd_ = -1;
+
+#ifndef _WIN32
+namespace
+{
+struct sigaction previous_winch;
+
+void onWinch(int sig, siginfo_t *info, void *context)
+{
+  int saved_errno = errno;
+
+  if (previous_winch.sa_flags & SA_SIGINFO)
+  {
+    if (previous_winch.sa_sigaction)
+      previous_winch.sa_sigaction(sig, info, context);
+  }
+  else if (previous_winch.sa_handler != SIG_DFL &&
+           previous_winch.sa_handler != SIG_IGN)
+  {
+    previous_winch.sa_handler(sig);
+  }
+
+  Wakeup::notify();
+  errno = saved_errno;
+}
+} // namespace
+#endif
+
+bool Wakeup::initialize()
+{
+#ifdef _WIN32
+  return false;
+#else
+  if (read_fd_ >= 0)
+    return true;
+
+#ifdef __linux__
+  int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (fd >= 0)
+  {
+    read_fd_ = write_fd_ = fd;
+    return true;
+  }
+#endif
+
+  int fds[2];
+  if (pipe(fds) != 0)
+  {
+    std::cerr << "Wakeup: pipe failed: " << strerror(errno) << std::endl;
+    return false;
+  }
+  for (int fd : fds)
+  {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+  }
+  read_fd_ = fds[0];
+  write_fd_ = fds[1];
+  return true;
+#endif
+}
+
+void Wakeup::notify()
+{
+#ifndef _WIN32
+  int fd = write_fd_;
+  if (fd < 0)
+    return;
+
+  // A full pipe or a saturated eventfd already means "wake up"
+  uint64_t one = 1;
+  ssize_t written;
+  do
+  {
+    written = write(fd, &one, fd == read_fd_ ? sizeof(one) : 1);
+  } while (written < 0 && errno == EINTR);
+#endif
+}
+
+int Wakeup::fd() { return read_fd_; }
+
+void Wakeup::clear()
+{
+#ifndef _WIN32
+  if (read_fd_ < 0)
+    return;
+
+  // An eventfd resets in one read; a pipe is read until empty
+  char drain[64];
+  while (true)
+  {
+    ssize_t got = read(read_fd_, drain, sizeof(drain));
+    if (got > 0 || (got < 0 && errno == EINTR))
+      continue;
+    break;
+  }
+#endif
+}
+
+bool Wakeup::watchResize()
+{
+#ifdef _WIN32
+  return false;
+#else
+  struct sigaction action;
+  std::memset(&action, 0, sizeof(action));
+  action.sa_sigaction = onWinch;
+  action.sa_flags = SA_SIGINFO | SA_RESTART;
+  sigemptyset(&action.sa_mask);
+
+  if (sigaction(SIGWINCH, &action, &previous_winch) != 0)
+  {
+    std::cerr << "Wakeup: SIGWINCH handler failed: " << strerror(errno)
+              << std::endl;
+    return false;
+  }
+  return true;
+#endif
+}
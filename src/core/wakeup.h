@@ -0,0 +1,34 @@
+// src/core/wakeup.h
+#pragma once
+
+// Wakes the main loop out of its wait for input.
+//
+// Background threads (parse and highlight workers, query compiles, the
+// config watcher, the clipboard worker) call notify() when they have
+// something for the UI thread; the main loop polls fd() next to stdin.
+// notify() only writes to a descriptor, so it is also safe from a signal
+// handler, which is how SIGWINCH reaches the loop.
+//
+// Uses an eventfd on Linux and a pipe on other POSIX systems. On Windows
+// everything is a no-op and the loop keeps blocking in getch().
+class Wakeup
+{
+public:
+  // The descriptors live until the process exits, since workers may still
+  // notify while they are being joined
+  static bool initialize();
+
+  static void notify();
+  // Descriptor that is readable after notify(); -1 if not initialized
+  static int fd();
+  // Consume pending notifications once the loop woke up
+  static void clear();
+
+  // Also notify on SIGWINCH, after the handler curses installed has run
+  // (so the next getch() still returns KEY_RESIZE). Call after initscr().
+  static bool watchResize();
+
+private:
+  static int read_fd_;
+  static int write_fd_;
+};
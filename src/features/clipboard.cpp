@@ -0,0 +1,432 @@
+// src/features/clipboard.cpp
+#include "clipboard.h"
+#include "src/core/wakeup.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#endif
+
+namespace
+{
+#ifndef _WIN32
+constexpr size_t STREAM_CHUNK = 64 * 1024;
+
+bool isInPath(const char *program)
+{
+  const char *path = std::getenv("PATH");
+  if (!path)
+    return false;
+
+  std::string dirs(path);
+  size_t start = 0;
+  while (start <= dirs.size())
+  {
+    size_t end = dirs.find(':', start);
+    if (end == std::string::npos)
+      end = dirs.size();
+
+    std::string dir = dirs.substr(start, end - start);
+    if (!dir.empty())
+    {
+      std::string candidate = dir + "/" + program;
+      if (access(candidate.c_str(), X_OK) == 0)
+        return true;
+    }
+    start = end + 1;
+  }
+  return false;
+}
+
+// Pipe whose ends are not inherited by helpers started from other threads
+// (a stray write end would keep a paste from ever seeing EOF)
+bool openPipe(int fds[2])
+{
+#if defined(__linux__) || defined(__FreeBSD__) || defined(__OpenBSD__) ||     \
+    defined(__NetBSD__)
+  return pipe2(fds, O_CLOEXEC) == 0;
+#else
+  if (pipe(fds) != 0)
+    return false;
+  fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+  fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+  return true;
+#endif
+}
+
+// Run a clipboard helper directly (no shell). Exactly one of input/output is
+// set: input is streamed to the helper's stdin, output collects its stdout.
+bool runHelper(const char *const argv[], const std::string *input,
+               std::string *output)
+{
+  int fds[2];
+  if (!openPipe(fds))
+    return false;
+
+  pid_t pid = fork();
+  if (pid < 0)
+  {
+    close(fds[0]);
+    close(fds[1]);
+    return false;
+  }
+
+  if (pid == 0)
+  {
+    int devnull = open("/dev/null", O_RDWR | O_CLOEXEC);
+    if (input)
+    {
+      dup2(fds[0], STDIN_FILENO);
+      dup2(devnull, STDOUT_FILENO);
+    }
+    else
+    {
+      dup2(devnull, STDIN_FILENO);
+      dup2(fds[1], STDOUT_FILENO);
+    }
+    dup2(devnull, STDERR_FILENO);
+    close(fds[0]);
+    close(fds[1]);
+#if defined(__linux__) && defined(SYS_close_range)
+    // Nor the terminal, the wakeup descriptor or the config watcher's
+    // inotify descriptor, whoever opened them
+    syscall(SYS_close_range, 3U, ~0U, 0U);
+#endif
+    execvp(argv[0], const_cast<char *const *>(argv));
+    _exit(127);
+  }
+
+  bool ok = true;
+  if (input)
+  {
+    close(fds[0]);
+    const char *data = input->data();
+    size_t remaining = input->size();
+    while (remaining > 0)
+    {
+      ssize_t written = write(fds[1], data, std::min(remaining, STREAM_CHUNK));
+      if (written < 0)
+      {
+        if (errno == EINTR)
+          continue;
+        ok = false;
+        break;
+      }
+      data += written;
+      remaining -= static_cast<size_t>(written);
+    }
+    close(fds[1]);
+  }
+  else
+  {
+    close(fds[1]);
+    char chunk[4096];
+    while (true)
+    {
+      ssize_t got = read(fds[0], chunk, sizeof(chunk));
+      if (got < 0)
+      {
+        if (errno == EINTR)
+          continue;
+        ok = false;
+        break;
+      }
+      if (got == 0)
+        break;
+      output->append(chunk, static_cast<size_t>(got));
+    }
+    close(fds[0]);
+  }
+
+  int status = 0;
+  while (waitpid(pid, &status, 0) < 0 && errno == EINTR)
+  {
+  }
+  return ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+#endif
+
+const char BASE64_ALPHABET[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+void appendBase64(std::string &out, const std::string &text)
+{
+  const unsigned char *data =
+      reinterpret_cast<const unsigned char *>(text.data());
+  size_t len = text.size();
+  size_t i = 0;
+
+  for (; i + 2 < len; i += 3)
+  {
+    uint32_t n = (data[i] << 16) | (data[i + 1] << 8) | data[i + 2];
+    out += BASE64_ALPHABET[(n >> 18) & 63];
+    out += BASE64_ALPHABET[(n >> 12) & 63];
+    out += BASE64_ALPHABET[(n >> 6) & 63];
+    out += BASE64_ALPHABET[n & 63];
+  }
+
+  if (i < len)
+  {
+    uint32_t n = data[i] << 16;
+    if (i + 1 < len)
+      n |= data[i + 1] << 8;
+    out += BASE64_ALPHABET[(n >> 18) & 63];
+    out += BASE64_ALPHABET[(n >> 12) & 63];
+    out += (i + 1 < len) ? BASE64_ALPHABET[(n >> 6) & 63] : '=';
+    out += '=';
+  }
+}
+} // namespace
+
+Clipboard::Clipboard()
+    : cached_(std::make_shared<const std::string>()),
+      refresh_requested_(true)
+{
+  worker_ = std::thread(&Clipboard::workerLoop, this);
+}
+
+Clipboard::~Clipboard()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  work_cv_.notify_all();
+  refresh_cv_.notify_all();
+  if (worker_.joinable())
+  {
+    worker_.join();
+  }
+}
+
+void Clipboard::copy(std::string text)
+{
+  // One allocation for the shared buffer; the text itself is moved, not copied
+  Text shared = std::make_shared<const std::string>(std::move(text));
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cached_ = shared;
+    pending_copy_ = std::move(shared);
+    cache_time_ = std::chrono::steady_clock::now();
+  }
+  work_cv_.notify_one();
+}
+
+Clipboard::Text Clipboard::paste()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  refresh_requested_ = true;
+  work_cv_.notify_one();
+
+  // A stale cache gets a short grace period so a quick helper still wins;
+  // a slow or missing one never blocks the input thread for long.
+  auto age = std::chrono::steady_clock::now() - cache_time_;
+  if (age > std::chrono::milliseconds(CACHE_FRESH_MS))
+  {
+    uint64_t generation = refresh_generation_;
+    refresh_cv_.wait_for(lock, std::chrono::milliseconds(PASTE_WAIT_MS),
+                         [&]
+                         { return stop_ || refresh_generation_ != generation; });
+  }
+
+  return cached_;
+}
+
+void Clipboard::flushTerminalOutput()
+{
+  std::string output;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (terminal_output_.empty())
+      return;
+    output.swap(terminal_output_);
+  }
+
+  fwrite(output.data(), 1, output.size(), stdout);
+  fflush(stdout);
+}
+
+void Clipboard::workerLoop()
+{
+#ifndef _WIN32
+  // A helper that exits early must surface as EPIPE, not kill the editor
+  sigset_t mask;
+  sigemptyset(&mask);
+  sigaddset(&mask, SIGPIPE);
+  pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+#endif
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true)
+  {
+    work_cv_.wait(lock, [this]
+                  { return stop_ || pending_copy_ || refresh_requested_; });
+    if (stop_)
+      break;
+
+    if (backend_ == Backend::UNKNOWN)
+    {
+      lock.unlock();
+      backend_ = detectBackend();
+      lock.lock();
+    }
+
+    // Copies first: only the most recent one is pushed to the system
+    if (pending_copy_)
+    {
+      Text text = std::move(pending_copy_);
+      pending_copy_.reset();
+      lock.unlock();
+      writeToSystem(*text);
+      lock.lock();
+      continue;
+    }
+
+    refresh_requested_ = false;
+    lock.unlock();
+    std::string fresh;
+    bool ok = readFromSystem(fresh);
+    lock.lock();
+
+    // A copy issued while we were reading is newer than what we just read
+    if (ok && !fresh.empty() && !pending_copy_ && *cached_ != fresh)
+    {
+      cached_ = std::make_shared<const std::string>(std::move(fresh));
+    }
+    cache_time_ = std::chrono::steady_clock::now();
+    refresh_generation_++;
+    refresh_cv_.notify_all();
+  }
+}
+
+Clipboard::Backend Clipboard::detectBackend() const
+{
+#ifdef _WIN32
+  return Backend::NONE;
+#else
+#ifdef __APPLE__
+  if (isInPath("pbcopy") && isInPath("pbpaste"))
+    return Backend::PBCOPY;
+#endif
+  if (std::getenv("WAYLAND_DISPLAY") && isInPath("wl-copy") &&
+      isInPath("wl-paste"))
+    return Backend::WAYLAND;
+  if (std::getenv("DISPLAY"))
+  {
+    if (isInPath("xclip"))
+      return Backend::XCLIP;
+    if (isInPath("xsel"))
+      return Backend::XSEL;
+  }
+  // No local clipboard service: let the terminal own the clipboard
+  if (isatty(STDOUT_FILENO))
+    return Backend::OSC52;
+  return Backend::NONE;
+#endif
+}
+
+bool Clipboard::writeToSystem(const std::string &text)
+{
+#ifndef _WIN32
+  switch (backend_)
+  {
+  case Backend::WAYLAND:
+  {
+    const char *const argv[] = {"wl-copy", nullptr};
+    return runHelper(argv, &text, nullptr);
+  }
+  case Backend::XCLIP:
+  {
+    const char *const argv[] = {"xclip", "-selection", "clipboard", nullptr};
+    return runHelper(argv, &text, nullptr);
+  }
+  case Backend::XSEL:
+  {
+    const char *const argv[] = {"xsel", "--clipboard", "--input", nullptr};
+    return runHelper(argv, &text, nullptr);
+  }
+  case Backend::PBCOPY:
+  {
+    const char *const argv[] = {"pbcopy", nullptr};
+    return runHelper(argv, &text, nullptr);
+  }
+  case Backend::OSC52:
+    queueOsc52(text);
+    return true;
+  default:
+    break;
+  }
+#else
+  (void)text;
+#endif
+  return false;
+}
+
+bool Clipboard::readFromSystem(std::string &out)
+{
+#ifndef _WIN32
+  switch (backend_)
+  {
+  case Backend::WAYLAND:
+  {
+    const char *const argv[] = {"wl-paste", "--no-newline", nullptr};
+    return runHelper(argv, nullptr, &out);
+  }
+  case Backend::XCLIP:
+  {
+    const char *const argv[] = {"xclip", "-selection", "clipboard", "-o",
+                                nullptr};
+    return runHelper(argv, nullptr, &out);
+  }
+  case Backend::XSEL:
+  {
+    const char *const argv[] = {"xsel", "--clipboard", "--output", nullptr};
+    return runHelper(argv, nullptr, &out);
+  }
+  case Backend::PBCOPY:
+  {
+    const char *const argv[] = {"pbpaste", nullptr};
+    return runHelper(argv, nullptr, &out);
+  }
+  default:
+    // OSC 52 reads need a terminal round-trip; the internal cache is the
+    // source of truth instead
+    break;
+  }
+#else
+  (void)out;
+#endif
+  return false;
+}
+
+void Clipboard::queueOsc52(const std::string &text)
+{
+  // tmux only forwards OSC 52 when wrapped in a DCS passthrough
+  bool in_tmux = std::getenv("TMUX") != nullptr;
+
+  std::string sequence;
+  sequence.reserve(text.size() / 3 * 4 + 32);
+  sequence += in_tmux ? "\033Ptmux;\033\033]52;c;" : "\033]52;c;";
+  appendBase64(sequence, text);
+  sequence += in_tmux ? "\a\033\\" : "\a";
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    terminal_output_ = std::move(sequence);
+  }
+  Wakeup::notify(); // Written by the UI thread between frames
+}
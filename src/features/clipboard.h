@@ -0,0 +1,81 @@
+// src/features/clipboard.h
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// System clipboard bridge.
+//
+// All helper-process and terminal I/O happens on a dedicated worker thread so
+// the input thread never forks or blocks. Copies are fire-and-forget: the text
+// is moved into a shared immutable buffer that doubles as the paste cache, and
+// the worker streams it straight from that buffer. Pastes return the cached
+// value and ask the worker to refresh it from the system clipboard.
+//
+// When no clipboard helper is reachable (SSH, console, no X/Wayland), copies
+// are encoded as OSC 52 sequences. Those are handed back to the UI thread and
+// written by flushTerminalOutput() so they never interleave with curses output.
+class Clipboard
+{
+public:
+  using Text = std::shared_ptr<const std::string>;
+
+  Clipboard();
+  ~Clipboard();
+
+  Clipboard(const Clipboard &) = delete;
+  Clipboard &operator=(const Clipboard &) = delete;
+
+  // Publish text to the internal cache and queue it for the system clipboard
+  void copy(std::string text);
+
+  // Cached clipboard contents (never null). Triggers a background refresh.
+  Text paste();
+
+  // Write any pending OSC 52 sequence; call from the UI thread after a frame
+  void flushTerminalOutput();
+
+private:
+  enum class Backend
+  {
+    UNKNOWN,
+    NONE, // Internal cache only
+    WAYLAND,
+    XCLIP,
+    XSEL,
+    PBCOPY,
+    OSC52
+  };
+
+  void workerLoop();
+  Backend detectBackend() const;
+  bool writeToSystem(const std::string &text);
+  bool readFromSystem(std::string &out);
+  void queueOsc52(const std::string &text);
+
+  // How long paste() waits for an in-flight refresh before using the cache
+  static constexpr int PASTE_WAIT_MS = 30;
+  // Cache younger than this is returned without waiting
+  static constexpr int CACHE_FRESH_MS = 1000;
+
+  std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::condition_variable refresh_cv_;
+  std::thread worker_;
+
+  // Shared state (guarded by mutex_)
+  Text cached_;
+  Text pending_copy_; // Latest copy not yet pushed to the system
+  bool refresh_requested_ = false;
+  bool stop_ = false;
+  uint64_t refresh_generation_ = 0;
+  std::chrono::steady_clock::time_point cache_time_;
+  std::string terminal_output_;
+
+  // Worker-only state
+  Backend backend_ = Backend::UNKNOWN;
+};
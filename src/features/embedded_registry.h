@@ -0,0 +1,123 @@
+// src/features/embedded_registry.h
+#pragma once
+
+#ifdef ARC_EMBEDDED_REGISTRY
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+
+// languages.yaml and its merged query sources, compiled in by CMake (see
+// "Embedded Language Registry" in CMakeLists.txt)
+struct EmbeddedLanguage
+{
+  const char *name;
+  const char *parser_name;
+  const char *library;
+  bool builtin;
+  bool injection_only;
+  const char *const *query_paths; // As listed in languages.yaml
+  size_t query_path_count;
+  const unsigned char *queries; // Merged highlight query source
+  size_t queries_size;
+  const char *const *injection_paths;
+  size_t injection_path_count;
+  const unsigned char *injections; // Merged injection query source
+  size_t injections_size;
+};
+
+struct EmbeddedExtension
+{
+  const char *extension;
+  int language; // Index into kEmbeddedLanguages
+};
+
+#include "embedded_languages.h" // Generated by CMake
+
+namespace embedded_registry
+{
+
+constexpr uint32_t hashExtension(std::string_view extension, uint32_t seed)
+{
+  uint32_t hash = 2166136261u ^ seed; // FNV-1a
+  for (char c : extension)
+  {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 16777619u;
+  }
+  // FNV's low bits barely depend on the seed; mix before masking
+  hash ^= hash >> 16;
+  hash *= 0x85ebca6bu;
+  hash ^= hash >> 13;
+  hash *= 0xc2b2ae35u;
+  hash ^= hash >> 16;
+  return hash;
+}
+
+constexpr size_t slotCount(size_t extensions)
+{
+  size_t slots = 1;
+  while (slots < extensions * 2)
+    slots <<= 1;
+  return slots;
+}
+
+template <size_t Slots> struct ExtensionTable
+{
+  uint32_t seed = 0;
+  int16_t entry[Slots] = {}; // Index into kEmbeddedExtensions, or -1
+};
+
+// Perfect hash: try seeds until every extension lands in its own slot
+template <size_t Slots, size_t N>
+constexpr ExtensionTable<Slots>
+buildExtensionTable(const EmbeddedExtension (&extensions)[N])
+{
+  ExtensionTable<Slots> table;
+  for (uint32_t seed = 0;; ++seed)
+  {
+    table.seed = seed;
+    for (auto &slot : table.entry)
+      slot = -1;
+
+    bool collided = false;
+    for (size_t i = 0; i < N && !collided; ++i)
+    {
+      size_t slot = hashExtension(extensions[i].extension, seed) & (Slots - 1);
+      if (table.entry[slot] >= 0)
+        collided = true;
+      else
+        table.entry[slot] = static_cast<int16_t>(i);
+    }
+    if (!collided)
+      return table;
+  }
+}
+
+inline constexpr size_t kExtensionSlots =
+    slotCount(std::size(kEmbeddedExtensions));
+inline constexpr auto kExtensionTable =
+    buildExtensionTable<kExtensionSlots>(kEmbeddedExtensions);
+
+} // namespace embedded_registry
+
+// Index into kEmbeddedLanguages for a file extension, or -1
+constexpr int findEmbeddedLanguage(std::string_view extension)
+{
+  using namespace embedded_registry;
+  size_t slot = hashExtension(extension, kExtensionTable.seed) &
+                (kExtensionSlots - 1);
+  int entry = kExtensionTable.entry[slot];
+  if (entry < 0 || extension != kEmbeddedExtensions[entry].extension)
+    return -1;
+  return kEmbeddedExtensions[entry].language;
+}
+
+inline std::string_view embeddedSource(const unsigned char *data, size_t size)
+{
+  return data ? std::string_view(reinterpret_cast<const char *>(data), size)
+              : std::string_view();
+}
+
+#endif
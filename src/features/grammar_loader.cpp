@@ -0,0 +1,155 @@
+// src/features/grammar_loader.cpp
+#include "grammar_loader.h"
+
+#ifdef TREE_SITTER_ENABLED
+
+#include <filesystem>
+#include <iostream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#include <unistd.h>
+#ifdef __APPLE__
+#include <mach-o/dyld.h>
+#endif
+#endif
+
+// Set by CMake; the fallbacks match a build run from the source directory.
+// ARC_GRAMMAR_DIR is only used when there is no grammars/ directory next to
+// the executable (see defaultLibraryPath()).
+#ifndef ARC_GRAMMAR_DIR
+#define ARC_GRAMMAR_DIR "build/grammars"
+#endif
+#ifndef ARC_GRAMMAR_SUFFIX
+#ifdef _WIN32
+#define ARC_GRAMMAR_SUFFIX ".dll"
+#else
+#define ARC_GRAMMAR_SUFFIX ".so"
+#endif
+#endif
+
+GrammarLoader &GrammarLoader::instance()
+{
+  static GrammarLoader loader;
+  return loader;
+}
+
+namespace
+{
+// Directory holding the running executable; empty if it cannot be found
+std::filesystem::path executableDir()
+{
+  std::string path;
+#if defined(_WIN32)
+  char buffer[MAX_PATH];
+  DWORD length = GetModuleFileNameA(nullptr, buffer, MAX_PATH);
+  if (length > 0 && length < MAX_PATH)
+    path.assign(buffer, length);
+#elif defined(__APPLE__)
+  char buffer[4096];
+  uint32_t size = sizeof(buffer);
+  if (_NSGetExecutablePath(buffer, &size) == 0)
+    path = buffer;
+#else
+  char buffer[4096];
+  ssize_t length = readlink("/proc/self/exe", buffer, sizeof(buffer) - 1);
+  if (length > 0)
+    path.assign(buffer, static_cast<size_t>(length));
+#endif
+  if (path.empty())
+    return {};
+
+  std::error_code error;
+  std::filesystem::path resolved = std::filesystem::canonical(path, error);
+  return (error ? std::filesystem::path(path) : resolved).parent_path();
+}
+} // namespace
+
+std::string GrammarLoader::defaultLibraryPath(const std::string &parser_name)
+{
+  std::string file_name =
+      "tree-sitter-" + parser_name + std::string(ARC_GRAMMAR_SUFFIX);
+
+  // Plugins travel with the executable, so an installed or moved Arc finds
+  // them; the build tree's directory is the fallback
+  static const std::filesystem::path exe_dir = executableDir();
+  if (!exe_dir.empty())
+  {
+    std::error_code error;
+    std::filesystem::path local = exe_dir / "grammars" / file_name;
+    if (std::filesystem::exists(local, error))
+      return local.string();
+  }
+
+  return std::string(ARC_GRAMMAR_DIR) + "/" + file_name;
+}
+
+const TSLanguage *GrammarLoader::load(const std::string &parser_name,
+                                      const std::string &library)
+{
+  std::string path =
+      library.empty() ? defaultLibraryPath(parser_name) : library;
+  std::string symbol = "tree_sitter_" + parser_name;
+
+  std::string key = path + ":" + symbol;
+  auto cached = loaded_.find(key);
+  if (cached != loaded_.end())
+    return cached->second;
+
+  using LanguageFunction = const TSLanguage *(*)();
+  LanguageFunction function = nullptr;
+
+#ifdef _WIN32
+  HMODULE handle = LoadLibraryA(path.c_str());
+  if (handle)
+  {
+    function = reinterpret_cast<LanguageFunction>(
+        GetProcAddress(handle, symbol.c_str()));
+  }
+  else
+  {
+    std::cerr << "WARNING: Cannot load grammar library " << path << " (error "
+              << GetLastError() << ")" << std::endl;
+  }
+#else
+  void *handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (handle)
+  {
+    function = reinterpret_cast<LanguageFunction>(dlsym(handle, symbol.c_str()));
+  }
+  else
+  {
+    std::cerr << "WARNING: Cannot load grammar library: " << dlerror()
+              << std::endl;
+  }
+#endif
+
+  const TSLanguage *language = nullptr;
+  if (handle && !function)
+  {
+    std::cerr << "WARNING: " << path << " does not export " << symbol
+              << std::endl;
+  }
+  else if (function)
+  {
+    language = function();
+    uint32_t abi = language ? ts_language_abi_version(language) : 0;
+    if (abi < TREE_SITTER_MIN_COMPATIBLE_LANGUAGE_VERSION ||
+        abi > TREE_SITTER_LANGUAGE_VERSION)
+    {
+      std::cerr << "WARNING: Grammar " << path << " has ABI version " << abi
+                << ", expected " << TREE_SITTER_MIN_COMPATIBLE_LANGUAGE_VERSION
+                << "-" << TREE_SITTER_LANGUAGE_VERSION << std::endl;
+      language = nullptr;
+    }
+  }
+
+  // The library stays open either way: a failed grammar is not retried and
+  // a loaded one must outlive every tree built from it
+  loaded_[key] = language;
+  return language;
+}
+
+#endif
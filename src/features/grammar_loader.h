@@ -0,0 +1,36 @@
+// src/features/grammar_loader.h
+#pragma once
+
+#ifdef TREE_SITTER_ENABLED
+
+#include <string>
+#include <unordered_map>
+
+#include <tree_sitter/api.h>
+
+// Grammars shipped as shared objects instead of being linked into Arc.
+//
+// With ARC_DYNAMIC_GRAMMARS every bundled grammar is built this way; any
+// language in languages.yaml can also name its own `library:`. A grammar is
+// opened the first time a buffer needs it and is never closed, since trees
+// and queries keep pointing into it.
+class GrammarLoader
+{
+public:
+  static GrammarLoader &instance();
+
+  // Open `library` (the grammar directory's default when empty) and resolve
+  // tree_sitter_<parser_name>. Null if that fails; each path is tried once.
+  const TSLanguage *load(const std::string &parser_name,
+                         const std::string &library);
+
+  static std::string defaultLibraryPath(const std::string &parser_name);
+
+private:
+  GrammarLoader() = default;
+
+  // Keyed by path and symbol; failures are remembered as null
+  std::unordered_map<std::string, const TSLanguage *> loaded_;
+};
+
+#endif
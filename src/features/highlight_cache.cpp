@@ -0,0 +1,144 @@
+// src/features/highlight_cache.cpp
+#include "highlight_cache.h"
+
+#include <algorithm>
+
+bool HighlightCache::contains(int line) const
+{
+  return line >= 0 && line < static_cast<int>(lines_.size()) &&
+         isValid(lines_[line]);
+}
+
+bool HighlightCache::lookup(int line, std::vector<ColorSpan> &out) const
+{
+  if (!contains(line))
+    return false;
+
+  const Entry &entry = lines_[line];
+  out.assign(arena_.begin() + entry.offset,
+             arena_.begin() + entry.offset + entry.count);
+  return true;
+}
+
+void HighlightCache::store(int line, const std::vector<ColorSpan> &spans)
+{
+  if (line < 0)
+    return;
+
+  if (line >= static_cast<int>(lines_.size()))
+  {
+    lines_.resize(line + 1);
+  }
+
+  Entry &entry = lines_[line];
+  drop(entry);
+
+  entry.offset = static_cast<uint32_t>(arena_.size());
+  entry.count = static_cast<uint32_t>(spans.size());
+  entry.stamp = generation_;
+  arena_.insert(arena_.end(), spans.begin(), spans.end());
+
+  live_lines_++;
+  live_spans_ += spans.size();
+  compactIfNeeded();
+}
+
+void HighlightCache::invalidate(int line)
+{
+  if (line >= 0 && line < static_cast<int>(lines_.size()))
+  {
+    drop(lines_[line]);
+  }
+}
+
+void HighlightCache::invalidateRange(int firstLine, int lastLine)
+{
+  firstLine = std::max(firstLine, 0);
+  lastLine = std::min(lastLine, static_cast<int>(lines_.size()) - 1);
+  for (int line = firstLine; line <= lastLine; ++line)
+  {
+    drop(lines_[line]);
+  }
+}
+
+void HighlightCache::invalidateFrom(int line)
+{
+  line = std::max(line, 0);
+  if (line >= static_cast<int>(lines_.size()))
+    return;
+
+  for (size_t i = line; i < lines_.size(); ++i)
+  {
+    drop(lines_[i]);
+  }
+  lines_.resize(line);
+}
+
+void HighlightCache::clear()
+{
+  // Every stored stamp becomes stale at once
+  generation_++;
+  if (generation_ == 0)
+  {
+    // Wrapped around: old stamps could collide, so reset them for real
+    lines_.assign(lines_.size(), Entry{});
+    generation_ = 1;
+  }
+
+  arena_.clear();
+  live_lines_ = 0;
+  live_spans_ = 0;
+}
+
+void HighlightCache::insertLines(int line, int count)
+{
+  if (count <= 0 || line < 0 || line >= static_cast<int>(lines_.size()))
+    return;
+
+  lines_.insert(lines_.begin() + line, count, Entry{});
+}
+
+void HighlightCache::eraseLines(int line, int count)
+{
+  if (count <= 0 || line < 0 || line >= static_cast<int>(lines_.size()))
+    return;
+
+  size_t end = std::min(lines_.size(), static_cast<size_t>(line) + count);
+  for (size_t i = line; i < end; ++i)
+  {
+    drop(lines_[i]);
+  }
+  lines_.erase(lines_.begin() + line, lines_.begin() + end);
+}
+
+void HighlightCache::drop(Entry &entry)
+{
+  if (!isValid(entry))
+    return;
+
+  live_lines_--;
+  live_spans_ -= entry.count;
+  entry.stamp = 0;
+}
+
+void HighlightCache::compactIfNeeded()
+{
+  if (arena_.size() < COMPACT_THRESHOLD || arena_.size() < 2 * live_spans_)
+    return;
+
+  std::vector<ColorSpan> compacted;
+  compacted.reserve(live_spans_ * 2);
+
+  for (Entry &entry : lines_)
+  {
+    if (!isValid(entry))
+      continue;
+
+    uint32_t offset = static_cast<uint32_t>(compacted.size());
+    compacted.insert(compacted.end(), arena_.begin() + entry.offset,
+                     arena_.begin() + entry.offset + entry.count);
+    entry.offset = offset;
+  }
+
+  arena_.swap(compacted);
+}
@@ -0,0 +1,64 @@
+// src/features/highlight_cache.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct ColorSpan
+{
+  int start;
+  int end;
+  int colorPair;
+  int attribute;
+  int priority;
+};
+
+// Per-line highlight cache.
+//
+// Lines are a contiguous array of small entries that point into one shared
+// span arena, so a cached line costs no allocation of its own. Each entry
+// carries the generation it was stored in; clear() just bumps the generation.
+// Structural edits shift entries with insertLines()/eraseLines() instead of
+// discarding everything below the edit.
+class HighlightCache
+{
+public:
+  bool contains(int line) const;
+  // Copies the cached spans of `line` into `out`; false if not cached
+  bool lookup(int line, std::vector<ColorSpan> &out) const;
+  void store(int line, const std::vector<ColorSpan> &spans);
+
+  void invalidate(int line);
+  void invalidateRange(int firstLine, int lastLine);
+  void invalidateFrom(int line);
+  void clear();
+
+  // `count` new (uncached) lines appear at `line`; later entries move down
+  void insertLines(int line, int count);
+  // Lines [line, line + count) disappear; later entries move up
+  void eraseLines(int line, int count);
+
+  size_t size() const { return live_lines_; }
+
+private:
+  struct Entry
+  {
+    uint32_t offset = 0; // First span in arena_
+    uint32_t count = 0;
+    uint32_t stamp = 0; // Valid only when equal to generation_
+  };
+
+  bool isValid(const Entry &entry) const { return entry.stamp == generation_; }
+  void drop(Entry &entry);
+  void compactIfNeeded();
+
+  // Compact once dead spans outnumber live ones past this arena size
+  static constexpr size_t COMPACT_THRESHOLD = 4096;
+
+  std::vector<Entry> lines_;
+  std::vector<ColorSpan> arena_;
+  uint32_t generation_ = 1;
+  size_t live_lines_ = 0;
+  size_t live_spans_ = 0;
+};
@@ -0,0 +1,191 @@
+// src/features/highlight_workers.cpp
+#include "highlight_workers.h"
+
+#ifdef TREE_SITTER_ENABLED
+
+#include <algorithm>
+
+HighlightWorkers::HighlightWorkers(unsigned thread_count)
+{
+  thread_count = std::max(1u, thread_count);
+  for (unsigned i = 0; i < thread_count; ++i)
+  {
+    threads_.emplace_back(&HighlightWorkers::run, this);
+  }
+}
+
+HighlightWorkers::~HighlightWorkers()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+    discardQueue();
+  }
+  cv_.notify_all();
+  for (auto &thread : threads_)
+  {
+    if (thread.joinable())
+      thread.join();
+  }
+}
+
+uint64_t HighlightWorkers::submit(std::shared_ptr<const Snapshot> snapshot,
+                                  std::vector<Chunk> chunks)
+{
+  uint64_t batch;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    discardQueue();
+    results_.clear();
+    batch = ++batch_;
+    snapshot_ = std::move(snapshot);
+    for (auto &chunk : chunks)
+    {
+      queue_.push_back(chunk);
+    }
+  }
+  cv_.notify_all();
+  return batch;
+}
+
+void HighlightWorkers::cancel()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  discardQueue();
+  results_.clear();
+  batch_++;
+  snapshot_.reset();
+}
+
+bool HighlightWorkers::takeResults(std::vector<Result> &out)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (results_.empty())
+    return false;
+
+  out = std::move(results_);
+  results_.clear();
+  return true;
+}
+
+void HighlightWorkers::setResultCallback(std::function<void()> callback)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  on_result_ = std::move(callback);
+}
+
+void HighlightWorkers::run()
+{
+  TSQueryCursor *cursor = ts_query_cursor_new();
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true)
+  {
+    cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+    if (stop_)
+      break;
+
+    Chunk chunk = queue_.front();
+    queue_.pop_front();
+    uint64_t batch = batch_;
+    std::shared_ptr<const Snapshot> snapshot = snapshot_;
+    lock.unlock();
+
+    Result result;
+    result.batch = batch;
+    result.first_row = chunk.first_row;
+    result.rows.resize(chunk.last_row - chunk.first_row + 1);
+
+    ts_query_cursor_set_match_limit(cursor, snapshot->match_limit);
+    result.complete = collectSpans(
+        cursor, snapshot->query.get(), snapshot->color_pairs,
+        snapshot->line_offsets, ts_tree_root_node(chunk.tree),
+        snapshot->line_offsets[chunk.first_row],
+        snapshot->line_offsets[chunk.last_row + 1], chunk.first_row,
+        chunk.last_row, 0, chunk.first_row, result.rows, 100);
+    ts_tree_delete(chunk.tree);
+
+    lock.lock();
+    if (batch != batch_)
+      continue; // Superseded while running
+
+    results_.push_back(std::move(result));
+    if (on_result_)
+    {
+      std::function<void()> notify = on_result_;
+      lock.unlock();
+      notify();
+      lock.lock();
+    }
+  }
+
+  ts_query_cursor_delete(cursor);
+}
+
+void HighlightWorkers::discardQueue()
+{
+  for (auto &chunk : queue_)
+  {
+    ts_tree_delete(chunk.tree);
+  }
+  queue_.clear();
+}
+
+bool HighlightWorkers::collectSpans(
+    TSQueryCursor *cursor, const TSQuery *query,
+    const std::vector<int> &color_pairs,
+    const std::vector<uint32_t> &line_offsets, TSNode root,
+    uint32_t start_byte, uint32_t end_byte, int first_row, int last_row,
+    int row_base, int rows_base, std::vector<std::vector<ColorSpan>> &rows,
+    int priority)
+{
+  // One cursor pass over the byte range; captures arrive in document order,
+  // so each row's spans come out sorted by start column
+  ts_query_cursor_set_byte_range(cursor, start_byte, end_byte);
+  ts_query_cursor_exec(cursor, query, root);
+
+  TSQueryMatch match;
+  uint32_t capture_index;
+  while (ts_query_cursor_next_capture(cursor, &match, &capture_index))
+  {
+    const TSQueryCapture &capture = match.captures[capture_index];
+
+    TSPoint start_point = ts_node_start_point(capture.node);
+    TSPoint end_point = ts_node_end_point(capture.node);
+
+    int span_first = std::max<int>(start_point.row, first_row);
+    int span_last = std::min<int>(end_point.row, last_row);
+    if (span_first > span_last)
+      continue;
+
+    int color_pair = capture.index < color_pairs.size()
+                         ? color_pairs[capture.index]
+                         : 0;
+    if (color_pair <= 0)
+      continue; // Helper captures (e.g. @_name) and unmapped names
+
+    for (int row = span_first; row <= span_last; ++row)
+    {
+      int line_length = static_cast<int>(line_offsets[row + 1] -
+                                         line_offsets[row] - 1);
+
+      int start_col =
+          (row == (int)start_point.row) ? (int)start_point.column : 0;
+      int end_col = (row == (int)end_point.row) ? (int)end_point.column
+                                                : line_length;
+
+      start_col = std::max(0, std::min(start_col, line_length));
+      end_col = std::max(start_col, std::min(end_col, line_length));
+
+      if (start_col < end_col)
+      {
+        rows[row + row_base - rows_base].push_back(
+            {start_col, end_col, color_pair, 0, priority});
+      }
+    }
+  }
+
+  return !ts_query_cursor_did_exceed_match_limit(cursor);
+}
+
+#endif
@@ -0,0 +1,97 @@
+// src/features/highlight_workers.h
+#pragma once
+
+#ifdef TREE_SITTER_ENABLED
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <tree_sitter/api.h>
+
+#include "src/features/highlight_cache.h"
+
+// Whole-document highlighting for SyntaxMode::FULL.
+//
+// A small pool of threads runs the highlight query over disjoint row ranges.
+// Each chunk carries its own ts_tree_copy() of the tree and each thread owns
+// its TSQueryCursor, so nothing is shared with the UI thread while a query
+// runs. Finished chunks wait until the owner stores them in its cache; a new
+// batch (or cancel()) makes queued and running chunks obsolete.
+class HighlightWorkers
+{
+public:
+  // Shared by every chunk of one batch
+  struct Snapshot
+  {
+    std::shared_ptr<TSQuery> query;
+    std::vector<int> color_pairs;
+    std::vector<uint32_t> line_offsets; // Start byte per row, plus the end
+    uint32_t match_limit = UINT32_MAX;
+  };
+
+  struct Chunk
+  {
+    TSTree *tree = nullptr; // Copy owned by the chunk
+    int first_row = 0;
+    int last_row = 0;
+  };
+
+  struct Result
+  {
+    uint64_t batch = 0;
+    int first_row = 0;
+    bool complete = true; // False if the match limit cut the query short
+    std::vector<std::vector<ColorSpan>> rows;
+  };
+
+  explicit HighlightWorkers(unsigned thread_count);
+  ~HighlightWorkers();
+
+  HighlightWorkers(const HighlightWorkers &) = delete;
+  HighlightWorkers &operator=(const HighlightWorkers &) = delete;
+
+  // Replace all pending work; returns the batch id results are tagged with
+  uint64_t submit(std::shared_ptr<const Snapshot> snapshot,
+                  std::vector<Chunk> chunks);
+  // Drop queued chunks and every result not yet taken
+  void cancel();
+  // Non-blocking: move out the results finished so far
+  bool takeResults(std::vector<Result> &out);
+  // Called on a worker thread whenever a result is ready
+  void setResultCallback(std::function<void()> callback);
+
+  // Append colored spans of `query` captures under `root` within
+  // [start_byte, end_byte) and rows [first_row, last_row]; row r lands in
+  // rows[r + row_base - rows_base]. False if the match limit hit.
+  static bool collectSpans(TSQueryCursor *cursor, const TSQuery *query,
+                           const std::vector<int> &color_pairs,
+                           const std::vector<uint32_t> &line_offsets,
+                           TSNode root, uint32_t start_byte,
+                           uint32_t end_byte, int first_row, int last_row,
+                           int row_base, int rows_base,
+                           std::vector<std::vector<ColorSpan>> &rows,
+                           int priority);
+
+private:
+  void run();
+  void discardQueue();
+
+  std::vector<std::thread> threads_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stop_ = false;
+  uint64_t batch_ = 0;
+  std::shared_ptr<const Snapshot> snapshot_;
+  std::deque<Chunk> queue_;
+  std::vector<Result> results_;
+  std::function<void()> on_result_;
+};
+
+#endif
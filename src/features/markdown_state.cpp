@@ -0,0 +1,128 @@
+// src/features/markdown_state.cpp
+#include "markdown_state.h"
+#include "src/core/buffer.h"
+
+MarkdownState MarkdownBlockStates::stateAt(const GapBuffer &buffer, int line)
+{
+  if (line < 0)
+    return MarkdownState::DEFAULT;
+
+  if (line >= static_cast<int>(lines_.size()))
+  {
+    extendTo(buffer, line);
+    if (line >= static_cast<int>(lines_.size()))
+      return MarkdownState::DEFAULT;
+  }
+  return lines_[line].display;
+}
+
+int MarkdownBlockStates::applyEdit(const GapBuffer &buffer, int startRow,
+                                   int oldEndRow, int newEndRow)
+{
+  int known = static_cast<int>(lines_.size());
+  if (startRow >= known)
+    return -1;
+
+  if (oldEndRow >= known)
+  {
+    // The edit runs past the scanned prefix, so nothing below it was known
+    lines_.resize(startRow);
+    return -1;
+  }
+
+  // Replace the edited rows with placeholders, then rescan from the top of
+  // the edit until a line below it hands on the same state as before
+  lines_.erase(lines_.begin() + startRow, lines_.begin() + oldEndRow + 1);
+  lines_.insert(lines_.begin() + startRow, newEndRow - startRow + 1,
+                LineState{});
+
+  int lineCount = buffer.getLineCount();
+  if (static_cast<int>(lines_.size()) > lineCount)
+  {
+    lines_.resize(lineCount);
+  }
+
+  MarkdownState entry =
+      startRow > 0 ? lines_[startRow - 1].exit : MarkdownState::DEFAULT;
+  int lastChanged = -1;
+
+  for (int i = startRow; i < static_cast<int>(lines_.size()); ++i)
+  {
+    LineState scanned = scanLine(buffer.getLine(i), entry);
+    if (i > newEndRow)
+    {
+      const LineState &cached = lines_[i];
+      if (scanned.display != cached.display)
+        lastChanged = i;
+
+      bool converged = scanned.exit == cached.exit;
+      lines_[i] = scanned;
+      if (converged)
+        break;
+    }
+    else
+    {
+      lines_[i] = scanned;
+    }
+    entry = scanned.exit;
+  }
+
+  return lastChanged;
+}
+
+void MarkdownBlockStates::invalidateFrom(int line)
+{
+  if (line < 0)
+    line = 0;
+  if (line < static_cast<int>(lines_.size()))
+  {
+    lines_.resize(line);
+  }
+}
+
+MarkdownBlockStates::LineState
+MarkdownBlockStates::scanLine(const std::string &line, MarkdownState entry)
+{
+  LineState state;
+  state.entry = entry;
+  state.display = entry;
+  state.exit = entry;
+
+  if (entry == MarkdownState::DEFAULT)
+  {
+    if (line.rfind("```", 0) == 0)
+    {
+      // The opening fence itself is drawn as regular Markdown
+      state.exit = MarkdownState::IN_FENCED_CODE_BLOCK;
+    }
+    else if (line.rfind(">", 0) == 0)
+    {
+      state.display = MarkdownState::IN_BLOCKQUOTE;
+    }
+  }
+  else if (entry == MarkdownState::IN_FENCED_CODE_BLOCK)
+  {
+    if (line.rfind("```", 0) == 0)
+    {
+      state.exit = MarkdownState::DEFAULT;
+    }
+  }
+
+  return state;
+}
+
+void MarkdownBlockStates::extendTo(const GapBuffer &buffer, int line)
+{
+  int lineCount = buffer.getLineCount();
+  if (line >= lineCount)
+    line = lineCount - 1;
+
+  MarkdownState entry =
+      lines_.empty() ? MarkdownState::DEFAULT : lines_.back().exit;
+  for (int i = static_cast<int>(lines_.size()); i <= line; ++i)
+  {
+    LineState scanned = scanLine(buffer.getLine(i), entry);
+    lines_.push_back(scanned);
+    entry = scanned.exit;
+  }
+}
@@ -2,11 +2,53 @@
 
 #pragma once
 
-enum class MarkdownState
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class GapBuffer;
+
+enum class MarkdownState : uint8_t
 {
   DEFAULT = 0,          // Not inside any block
   IN_FENCED_CODE_BLOCK, // Inside ```...```
-  IN_HTML_COMMENT,      // Inside IN_BLOCKQUOTE,           // Inside a > block
+  IN_HTML_COMMENT,      // Inside <!-- ... -->
   // Add other multi-line states here (e.g., IN_MULTI_LINE_LIST)
   IN_BLOCKQUOTE
-};
\ No newline at end of file
+};
+
+// Fence and blockquote state of every Markdown line.
+//
+// Each line records the state it is entered in, the state it is drawn with
+// and the state it hands to the next line. Lines are scanned on demand from
+// the top, so only the prefix up to the lowest line asked for is known. An
+// edit rescans from the edited line and stops at the first line below the
+// edit whose exit state is unchanged, since nothing after it can differ.
+class MarkdownBlockStates
+{
+public:
+  // State `line` is drawn with, scanning forward to it if needed
+  MarkdownState stateAt(const GapBuffer &buffer, int line);
+
+  // Rows [startRow, oldEndRow] became [startRow, newEndRow] in `buffer`.
+  // Returns the last row whose drawn state changed, or -1 if none did.
+  int applyEdit(const GapBuffer &buffer, int startRow, int oldEndRow,
+                int newEndRow);
+
+  // Forget lines >= line; they are rescanned when next asked for
+  void invalidateFrom(int line);
+  void clear() { lines_.clear(); }
+
+private:
+  struct LineState
+  {
+    MarkdownState entry = MarkdownState::DEFAULT;
+    MarkdownState display = MarkdownState::DEFAULT;
+    MarkdownState exit = MarkdownState::DEFAULT;
+  };
+
+  static LineState scanLine(const std::string &line, MarkdownState entry);
+  void extendTo(const GapBuffer &buffer, int line);
+
+  std::vector<LineState> lines_; // Known prefix of the buffer
+};
@@ -0,0 +1,169 @@
+// src/features/parse_worker.cpp
+#include "parse_worker.h"
+
+#ifdef TREE_SITTER_ENABLED
+
+#include <iostream>
+
+// tree-sitter polls the flag through a plain size_t pointer
+static_assert(sizeof(std::atomic<size_t>) == sizeof(size_t),
+              "cancellation flag must be layout-compatible with size_t");
+
+ParseWorker::ParseWorker()
+{
+  parser_ = ts_parser_new();
+  if (!parser_)
+  {
+    std::cerr << "ERROR: Failed to create background parser" << std::endl;
+    return;
+  }
+
+  ts_parser_set_cancellation_flag(
+      parser_, reinterpret_cast<const size_t *>(&cancel_flag_));
+  thread_ = std::thread(&ParseWorker::run, this);
+}
+
+ParseWorker::~ParseWorker()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+    cancel_flag_.store(1);
+  }
+  cv_.notify_all();
+  if (thread_.joinable())
+  {
+    thread_.join();
+  }
+
+  discard(job_);
+  if (result_.tree)
+  {
+    ts_tree_delete(result_.tree);
+  }
+  if (parser_)
+  {
+    ts_parser_delete(parser_);
+  }
+}
+
+void ParseWorker::submit(Job job)
+{
+  if (!parser_)
+  {
+    discard(job);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    discard(job_);
+    job_ = std::move(job);
+    has_job_ = true;
+    if (running_)
+    {
+      cancel_flag_.store(1);
+    }
+  }
+  cv_.notify_one();
+}
+
+void ParseWorker::cancel()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  discard(job_);
+  has_job_ = false;
+  if (running_)
+  {
+    cancel_flag_.store(1);
+  }
+}
+
+bool ParseWorker::takeResult(Result &out)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!has_result_)
+    return false;
+
+  out = std::move(result_);
+  result_ = Result{};
+  has_result_ = false;
+  return true;
+}
+
+bool ParseWorker::isBusy() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return running_ || has_job_;
+}
+
+void ParseWorker::setResultCallback(std::function<void()> callback)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  on_result_ = std::move(callback);
+}
+
+void ParseWorker::run()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true)
+  {
+    cv_.wait(lock, [this] { return stop_ || has_job_; });
+    if (stop_)
+      break;
+
+    Job job = std::move(job_);
+    job_ = Job{};
+    has_job_ = false;
+    running_ = true;
+    cancel_flag_.store(0);
+    lock.unlock();
+
+    TSTree *tree = nullptr;
+    if (ts_parser_set_language(parser_, job.language))
+    {
+      tree = ts_parser_parse_string(parser_, job.old_tree, job.content.c_str(),
+                                    job.content.length());
+    }
+    if (!tree)
+    {
+      // Cancelled (or unusable language); leave no half-finished state behind
+      ts_parser_reset(parser_);
+    }
+    discard(job);
+
+    lock.lock();
+    running_ = false;
+    if (!tree)
+      continue;
+
+    // Only the newest finished tree is worth keeping
+    if (result_.tree)
+    {
+      ts_tree_delete(result_.tree);
+    }
+    result_.version = job.version;
+    result_.tree = tree;
+    result_.content = std::move(job.content);
+    has_result_ = true;
+
+    if (on_result_)
+    {
+      std::function<void()> notify = on_result_;
+      lock.unlock();
+      notify();
+      lock.lock();
+    }
+  }
+}
+
+void ParseWorker::discard(Job &job)
+{
+  if (job.old_tree)
+  {
+    ts_tree_delete(job.old_tree);
+    job.old_tree = nullptr;
+  }
+}
+
+#endif
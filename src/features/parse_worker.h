@@ -0,0 +1,78 @@
+// src/features/parse_worker.h
+#pragma once
+
+#ifdef TREE_SITTER_ENABLED
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <tree_sitter/api.h>
+
+// Long-lived background parser.
+//
+// Owns one TSParser and one thread for the lifetime of the highlighter. Jobs
+// coalesce: submitting replaces any queued job and cancels the parse in flight
+// (via ts_parser_set_cancellation_flag), since only the newest text matters.
+// Finished trees wait in a single result slot tagged with the version they were
+// parsed for; the owner adopts them on its own thread and drops stale ones.
+class ParseWorker
+{
+public:
+  struct Job
+  {
+    uint64_t version = 0;
+    const TSLanguage *language = nullptr;
+    std::string content;
+    TSTree *old_tree = nullptr; // Edited copy for incremental parsing (owned)
+  };
+
+  struct Result
+  {
+    uint64_t version = 0;
+    TSTree *tree = nullptr; // Ownership passes to the caller of takeResult()
+    std::string content;
+  };
+
+  ParseWorker();
+  ~ParseWorker();
+
+  ParseWorker(const ParseWorker &) = delete;
+  ParseWorker &operator=(const ParseWorker &) = delete;
+
+  // Queue a parse, superseding whatever is queued or running
+  void submit(Job job);
+  // Drop the queued job and abort the running one
+  void cancel();
+  // Non-blocking: move out the latest finished parse, if any
+  bool takeResult(Result &out);
+  bool isBusy() const;
+  // Called on the worker thread whenever a new result is ready
+  void setResultCallback(std::function<void()> callback);
+
+private:
+  void run();
+  static void discard(Job &job);
+
+  TSParser *parser_ = nullptr;
+  std::thread thread_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stop_ = false;
+  bool has_job_ = false;
+  bool running_ = false;
+  Job job_;
+  bool has_result_ = false;
+  Result result_;
+  std::function<void()> on_result_;
+
+  // Polled by tree-sitter while parsing; non-zero aborts the parse
+  std::atomic<size_t> cancel_flag_{0};
+};
+
+#endif
@@ -0,0 +1,165 @@
+// src/features/query_cache.cpp
+#include "query_cache.h"
+#include "src/core/wakeup.h"
+
+#ifdef TREE_SITTER_ENABLED
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+QueryCache &QueryCache::instance()
+{
+  static QueryCache cache;
+  return cache;
+}
+
+QueryCache::PendingQuery
+QueryCache::request(const TSLanguage *language,
+                    const std::vector<std::string> &paths,
+                    std::string_view embedded)
+{
+  if (!language || (paths.empty() && embedded.empty()))
+  {
+    // Nothing to compile: hand back an already finished null query
+    std::promise<QueryHandle> none;
+    none.set_value(nullptr);
+    return none.get_future().share();
+  }
+
+  // Embedded sources are static data, so their address and size name them
+  std::string key;
+  if (!embedded.empty())
+  {
+    key = "embedded:" +
+          std::to_string(reinterpret_cast<uintptr_t>(embedded.data())) + ":" +
+          std::to_string(embedded.size()) + "\n";
+  }
+  for (const auto &path : paths)
+  {
+    key += path;
+    key += '\n';
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find({language, key});
+  if (it != entries_.end())
+    return it->second;
+
+  // The result is published before the main loop is woken, so the loop
+  // always finds it ready and never has to poll for it
+  auto result = std::make_shared<std::promise<QueryHandle>>();
+  PendingQuery pending = result->get_future().share();
+  // Finished tasks have nothing left to wait for
+  tasks_.erase(std::remove_if(tasks_.begin(), tasks_.end(),
+                              [](const std::future<void> &task)
+                              {
+                                return task.wait_for(std::chrono::seconds(0)) ==
+                                       std::future_status::ready;
+                              }),
+               tasks_.end());
+  tasks_.push_back(std::async(
+      std::launch::async,
+      [result, language, paths, embedded]()
+      {
+        TSQuery *query = embedded.empty()
+                             ? compile(language, paths)
+                             : compileSource(language, std::string(embedded));
+        result->set_value(query ? QueryHandle(query, ts_query_delete)
+                                : QueryHandle());
+        Wakeup::notify();
+      }));
+  entries_.emplace(std::make_pair(language, key), pending);
+  return pending;
+}
+
+bool QueryCache::isReady(const PendingQuery &pending)
+{
+  return pending.valid() && pending.wait_for(std::chrono::seconds(0)) ==
+                                std::future_status::ready;
+}
+
+void QueryCache::clear()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.clear();
+}
+
+TSQuery *QueryCache::compile(const TSLanguage *language,
+                             const std::vector<std::string> &paths)
+{
+  if (!language || paths.empty())
+    return nullptr;
+
+  std::string merged_query_source;
+  for (const auto &query_path : paths)
+  {
+    std::ifstream file(query_path);
+    if (!file.is_open())
+    {
+      std::cerr << "ERROR: Cannot open query file: " << query_path
+                << std::endl;
+      continue;
+    }
+
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string query_content = buffer.str();
+
+    if (!query_content.empty())
+    {
+      // Add newline between queries for safety
+      if (!merged_query_source.empty())
+      {
+        merged_query_source += "\n";
+      }
+      merged_query_source += query_content;
+    }
+  }
+
+  return compileSource(language, merged_query_source);
+}
+
+TSQuery *QueryCache::compileSource(const TSLanguage *language,
+                                   const std::string &merged_query_source)
+{
+  if (!language || merged_query_source.empty())
+    return nullptr;
+
+  // Parse the merged query once
+  uint32_t error_offset;
+  TSQueryError error_type;
+  TSQuery *query =
+      ts_query_new(language, merged_query_source.c_str(),
+                   merged_query_source.length(), &error_offset, &error_type);
+
+  if (!query)
+  {
+    std::cerr << "ERROR: Failed to parse merged query" << std::endl;
+    std::cerr << "  Error offset: " << error_offset << std::endl;
+    std::cerr << "  Error type: " << error_type << std::endl;
+
+    // Show context around error
+    if (error_offset < merged_query_source.length())
+    {
+      int context_start = std::max(0, (int)error_offset - 50);
+      int context_end = std::min((int)merged_query_source.length(),
+                                 (int)error_offset + 50);
+
+      std::cerr << "Context around error:" << std::endl;
+      std::cerr << "..."
+                << merged_query_source.substr(context_start,
+                                              context_end - context_start)
+                << "..." << std::endl;
+      std::cerr << std::string(error_offset - context_start + 3, ' ') << "^"
+                << std::endl;
+    }
+  }
+
+  return query;
+}
+
+#endif
@@ -0,0 +1,60 @@
+// src/features/query_cache.h
+#pragma once
+
+#ifdef TREE_SITTER_ENABLED
+
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <tree_sitter/api.h>
+
+// Process-wide cache of compiled highlight and injection queries.
+//
+// Reading and compiling the .scm files of a large grammar is slow enough to
+// show at startup, so compilation runs on a background task that starts as
+// soon as the language is known. Every buffer of the same language shares one
+// compiled TSQuery (queries are immutable once built, so sharing across
+// threads is safe). Failed compiles are cached as null too. Finished
+// compiles wake the main loop (see Wakeup).
+class QueryCache
+{
+public:
+  using QueryHandle = std::shared_ptr<TSQuery>;
+  using PendingQuery = std::shared_future<QueryHandle>;
+
+  static QueryCache &instance();
+
+  // Start compiling the concatenation of `paths` for `language`, unless the
+  // same request was made before. A non-empty `embedded` source (compiled
+  // into Arc) stands in for reading the files. Never blocks.
+  PendingQuery request(const TSLanguage *language,
+                       const std::vector<std::string> &paths,
+                       std::string_view embedded = {});
+  static bool isReady(const PendingQuery &pending);
+
+  // Forget every entry (e.g. the query files changed on disk); queries still
+  // held by a highlighter stay valid
+  void clear();
+
+  // Concatenate query files and compile them; null if none could be used
+  static TSQuery *compile(const TSLanguage *language,
+                          const std::vector<std::string> &paths);
+  static TSQuery *compileSource(const TSLanguage *language,
+                                const std::string &source);
+
+private:
+  QueryCache() = default;
+
+  std::mutex mutex_;
+  std::map<std::pair<const TSLanguage *, std::string>, PendingQuery> entries_;
+  // Compile tasks; kept so the cache's destruction waits for them
+  std::vector<std::future<void>> tasks_;
+};
+
+#endif
@@ -1,5 +1,6 @@
 // src/features/syntax_config_loader.cpp
 #include "syntax_config_loader.h"
+#include "embedded_registry.h"
 #include <algorithm>
 #include <filesystem>
 #include <fstream>
@@ -73,6 +74,9 @@ bool SyntaxConfigLoader::parseRegistryFile(const std::string &filepath)
       if (lang_node["parser_name"])
         config->parser_name = lang_node["parser_name"].as<std::string>();
 
+      if (lang_node["library"])
+        config->library = lang_node["library"].as<std::string>();
+
       if (lang_node["query_path"])
         config->query_file_path = lang_node["query_path"].as<std::string>();
 
@@ -88,7 +92,23 @@ bool SyntaxConfigLoader::parseRegistryFile(const std::string &filepath)
         }
       }
 
-      // Parse extensions (CRITICAL: Must have at least one extension)
+      if (lang_node["injections"] && lang_node["injections"].IsSequence())
+      {
+        for (const auto &query_node : lang_node["injections"])
+        {
+          std::string query_path = query_node.as<std::string>();
+          if (!query_path.empty())
+          {
+            config->injections.push_back(query_path);
+          }
+        }
+      }
+
+      if (lang_node["injection_only"])
+        config->injection_only = lang_node["injection_only"].as<bool>();
+
+      // Parse extensions (CRITICAL: Must have at least one extension, unless
+      // the grammar is only reachable through injections)
       if (lang_node["extensions"] && lang_node["extensions"].IsSequence())
       {
         for (const auto &ext_node : lang_node["extensions"])
@@ -102,14 +122,14 @@ bool SyntaxConfigLoader::parseRegistryFile(const std::string &filepath)
           }
         }
 
-        if (config->extensions.empty())
+        if (config->extensions.empty() && !config->injection_only)
         {
           std::cerr << "WARNING: Language '" << lang_key
                     << "' has no valid extensions, skipping" << std::endl;
           continue; // Skip this language
         }
       }
-      else
+      else if (!config->injection_only)
       {
         std::cerr << "WARNING: Language '" << lang_key
                   << "' has no extensions defined, skipping" << std::endl;
@@ -186,9 +206,16 @@ std::string
 SyntaxConfigLoader::getLanguageFromExtension(const std::string &extension) const
 {
   auto it = extension_to_language_.find(extension);
-  std::string result =
-      (it != extension_to_language_.end()) ? it->second : "text";
-  return result;
+  if (it != extension_to_language_.end())
+    return it->second;
+
+#ifdef ARC_EMBEDDED_REGISTRY
+  // Not overridden by the user's languages.yaml
+  int embedded = findEmbeddedLanguage(extension);
+  if (embedded >= 0)
+    return kEmbeddedLanguages[embedded].name;
+#endif
+  return "text";
 }
 
 void SyntaxConfigLoader::debugCurrentState() const
@@ -227,6 +254,19 @@ void SyntaxConfigLoader::debugCurrentState() const
 bool SyntaxConfigLoader::loadAllLanguageConfigs(
     const std::string &config_directory)
 {
+#ifdef ARC_EMBEDDED_REGISTRY
+  // Built-in languages and queries come from the binary; a languages.yaml in
+  // the user's syntax directory only overrides or adds entries
+  loadEmbeddedRegistry();
+
+  std::string override_path = config_directory + "/languages.yaml";
+  std::error_code error;
+  if (std::filesystem::exists(override_path, error))
+  {
+    parseRegistryFile(override_path);
+  }
+  return !language_configs_.empty();
+#else
   // DEPRECATED: Check if registry.yaml exists first
   std::string registry_path = "treesitter/languages.yaml";
 
@@ -292,6 +332,45 @@ bool SyntaxConfigLoader::loadAllLanguageConfigs(
     std::cerr << "General error: " << ex.what() << std::endl;
     return false;
   }
+#endif
+}
+
+bool SyntaxConfigLoader::loadEmbeddedRegistry()
+{
+#ifdef ARC_EMBEDDED_REGISTRY
+  for (size_t i = 0; i < std::size(kEmbeddedLanguages); ++i)
+  {
+    const EmbeddedLanguage &embedded = kEmbeddedLanguages[i];
+    auto config = std::make_unique<LanguageConfig>();
+    config->name = embedded.name;
+    config->parser_name = embedded.parser_name;
+    config->library = embedded.library;
+    config->builtin = embedded.builtin;
+    config->injection_only = embedded.injection_only;
+    config->queries.assign(embedded.query_paths,
+                           embedded.query_paths + embedded.query_path_count);
+    config->injections.assign(embedded.injection_paths,
+                              embedded.injection_paths +
+                                  embedded.injection_path_count);
+    config->embedded_queries =
+        embeddedSource(embedded.queries, embedded.queries_size);
+    config->embedded_injections =
+        embeddedSource(embedded.injections, embedded.injections_size);
+
+    // Extensions resolve through the compiled-in perfect hash; the list is
+    // kept for introspection only
+    for (const EmbeddedExtension &extension : kEmbeddedExtensions)
+    {
+      if (extension.language == static_cast<int>(i))
+        config->extensions.push_back(extension.extension);
+    }
+
+    language_configs_[config->name] = std::move(config);
+  }
+  return true;
+#else
+  return false;
+#endif
 }
 
 bool SyntaxConfigLoader::parseYamlFile(const std::string &filepath,
@@ -2,6 +2,7 @@
 
 #include <memory>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -11,13 +12,21 @@ struct LanguageConfig
   std::string name;
   std::vector<std::string> extensions;
   bool builtin; // NEW: Is this a built-in language?
+  bool injection_only = false; // Only reachable through injections
 
   // Tree-sitter specific configuration
   std::string parser_name;     // e.g., "python" -> maps to tree_sitter_python()
+  std::string library; // Grammar shared object, opened on first use
   std::string query_file_path; // e.g., "syntax_rules/python.scm"
   std::vector<std::string>
       queries; // e.g., "javascript" -> queries/ecma/highlights.scm,
                // queries/javascript/highlights.scm
+  std::vector<std::string>
+      injections; // e.g., "markdown" -> queries/markdown/injections.scm
+  // Merged sources compiled into Arc; used instead of reading `queries` and
+  // `injections` from disk when set
+  std::string_view embedded_queries;
+  std::string_view embedded_injections;
 };
 
 class SyntaxConfigLoader
@@ -52,6 +61,9 @@ public:
   std::unordered_map<std::string, std::string> extension_to_language_;
 
 private:
+  // Languages compiled in by CMake; false if this build has none
+  bool loadEmbeddedRegistry();
+
   // Parse YAML registry file
   bool parseRegistryFile(const std::string &filepath);
 
@@ -1,9 +1,15 @@
 #include "syntax_highlighter.h"
+#include "highlight_workers.h"
+#include "grammar_loader.h"
+#include "query_cache.h"
 #include "src/core/config_manager.h"
+#include "src/core/wakeup.h"
 #include <algorithm>
+#include <cstdlib>
 #include <cstring>
 #include <fstream>
 #include <sstream>
+#include <thread>
 #ifdef _WIN32
 #include <curses.h>
 #else
@@ -22,7 +28,7 @@ SyntaxHighlighter::SyntaxHighlighter()
 #ifdef TREE_SITTER_ENABLED
       ,
       parser_(nullptr), tree_(nullptr), current_ts_language_(nullptr),
-      current_ts_query_(nullptr)
+      current_ts_query_(nullptr), query_cursor_(nullptr)
 #endif
 {
 #ifdef TREE_SITTER_ENABLED
@@ -50,28 +56,38 @@ bool SyntaxHighlighter::initialize(const std::string &config_directory)
     loadBasicRules();
     return false;
   }
+  // Runs on the config watcher thread: only flag the reload here and let the
+  // UI thread rebuild queries and color tables before its next frame.
   ConfigManager::registerReloadCallback(
-      [this, config_directory]()
+      [this]()
       {
         std::cerr << "Syntax config reload triggered." << std::endl;
-        // Clear old configs and reload them
-        config_loader_->language_configs_.clear();
-        config_loader_->extension_to_language_.clear();
-
-        // Reload all config files from the directory
-        this->config_loader_->loadAllLanguageConfigs(
-            ConfigManager::getSyntaxRulesDir());
-
-        // Re-apply the parser for the current file
-        setLanguage(this->currentLanguage); // Re-set language to pick up new
-                                            // rules/queries
-        // NOTE: Force a full buffer re-highlight/re-parse (e.g., set a flag)
+        reload_requested_ = true;
       });
 
   // std::cout << "Successfully loaded language configurations" << std::endl;
   return true;
 }
 
+void SyntaxHighlighter::applyPendingReload()
+{
+  if (!reload_requested_.exchange(false))
+    return;
+
+  // Clear old configs and reload them
+  config_loader_->language_configs_.clear();
+  config_loader_->extension_to_language_.clear();
+  config_loader_->loadAllLanguageConfigs(ConfigManager::getSyntaxRulesDir());
+
+  // Re-apply the parser for the current file; this recompiles the query and
+  // rebuilds the capture color table against the (possibly new) theme
+#ifdef TREE_SITTER_ENABLED
+  QueryCache::instance().clear();
+#endif
+  setLanguage(current_extension_);
+  line_cache_.clear();
+}
+
 #ifdef TREE_SITTER_ENABLED
 
 void SyntaxHighlighter::diagnoseGrammar() const
@@ -113,6 +129,7 @@ void SyntaxHighlighter::diagnoseGrammar() const
 
 void SyntaxHighlighter::setLanguage(const std::string &extension)
 {
+  current_extension_ = extension;
   std::string language_name =
       config_loader_->getLanguageFromExtension(extension);
 
@@ -123,11 +140,13 @@ void SyntaxHighlighter::setLanguage(const std::string &extension)
   {
     current_language_config_ = config;
     currentLanguage = language_name;
+    markdown_states_.clear();
 
 #ifdef TREE_SITTER_ENABLED
     if (!config->parser_name.empty() && parser_)
     {
-      const TSLanguage *ts_language = getLanguageFunction(config->parser_name);
+      const TSLanguage *ts_language =
+          getLanguageFunction(config->parser_name, config->library);
       if (ts_language)
       {
         if (!ts_parser_set_language(parser_, ts_language))
@@ -136,78 +155,40 @@ void SyntaxHighlighter::setLanguage(const std::string &extension)
           loadBasicRules();
           return;
         }
-        current_ts_language_ = ts_language;
-
-        // Clean up old query
-        if (current_ts_query_)
-        {
-          ts_query_delete(current_ts_query_);
-          current_ts_query_ = nullptr;
-        }
-
-        // Load and merge all queries
-        if (!config->queries.empty())
+        if (ts_language != current_ts_language_)
         {
-          std::string merged_query_source;
-
-          for (const auto &query_path : config->queries)
+          // A tree for the previous grammar must never be adopted
+          tree_version_++;
+          if (parse_worker_)
           {
-            std::ifstream file(query_path);
-            if (!file.is_open())
-            {
-              std::cerr << "ERROR: Cannot open query file: " << query_path
-                        << std::endl;
-              continue;
-            }
-
-            std::stringstream buffer;
-            buffer << file.rdbuf();
-            std::string query_content = buffer.str();
-
-            if (!query_content.empty())
-            {
-              // Add newline between queries for safety
-              if (!merged_query_source.empty())
-              {
-                merged_query_source += "\n";
-              }
-              merged_query_source += query_content;
-            }
+            parse_worker_->cancel();
           }
-
-          // Parse the merged query once
-          if (!merged_query_source.empty())
+          if (highlight_workers_)
           {
-            uint32_t error_offset;
-            TSQueryError error_type;
-            current_ts_query_ = ts_query_new(
-                current_ts_language_, merged_query_source.c_str(),
-                merged_query_source.length(), &error_offset, &error_type);
-
-            if (!current_ts_query_)
-            {
-              std::cerr << "ERROR: Failed to parse merged query" << std::endl;
-              std::cerr << "  Error offset: " << error_offset << std::endl;
-              std::cerr << "  Error type: " << error_type << std::endl;
-
-              // Show context around error
-              if (error_offset < merged_query_source.length())
-              {
-                int context_start = std::max(0, (int)error_offset - 50);
-                int context_end = std::min((int)merged_query_source.length(),
-                                           (int)error_offset + 50);
-
-                std::cerr << "Context around error:" << std::endl;
-                std::cerr << "..."
-                          << merged_query_source.substr(
-                                 context_start, context_end - context_start)
-                          << "..." << std::endl;
-                std::cerr << std::string(error_offset - context_start + 3, ' ')
-                          << "^" << std::endl;
-              }
-            }
+            highlight_workers_->cancel();
           }
         }
+        current_ts_language_ = ts_language;
+
+        // Drop old queries and every injected region built on them
+        current_ts_query_ = nullptr;
+        highlight_query_.reset();
+        capture_color_pairs_.clear();
+        current_injection_query_ = nullptr;
+        injection_query_.reset();
+        clearInjections();
+        injected_languages_.clear();
+
+        // Compile off the UI thread; frames use basic highlighting until
+        // the queries land (immediately if another buffer compiled them).
+        // Injection points are matched separately from highlights.
+        QueryCache &queries = QueryCache::instance();
+        pending_highlight_query_ = queries.request(
+            current_ts_language_, config->queries, config->embedded_queries);
+        pending_injection_query_ =
+            queries.request(current_ts_language_, config->injections,
+                            config->embedded_injections);
+        adoptCompiledQueries();
       }
       else
       {
@@ -243,22 +224,22 @@ SyntaxHighlighter::getHighlightSpans(const std::string &line, int lineIndex,
                                      const GapBuffer &buffer) const
 {
   // Check cache first
-  auto cache_it = line_cache_.find(lineIndex);
-  if (cache_it != line_cache_.end())
+  std::vector<ColorSpan> cached;
+  if (line_cache_.lookup(lineIndex, cached))
   {
-    return cache_it->second;
+    return cached;
   }
 
   // Handle Markdown special states
-  if (currentLanguage == "Markdown" && line_states_.count(lineIndex))
+  if (currentLanguage == "Markdown")
   {
-    MarkdownState state = line_states_.at(lineIndex);
-    if (state == MarkdownState::IN_FENCED_CODE_BLOCK)
+    MarkdownState state = markdown_states_.stateAt(buffer, lineIndex);
+    if (state == MarkdownState::IN_FENCED_CODE_BLOCK && !hasInjections())
     {
       std::vector<ColorSpan> result = {
           {0, (int)line.length(), getColorPairValue("MARKDOWN_CODE_BLOCK"),
            A_NORMAL, 100}};
-      line_cache_[lineIndex] = result;
+      line_cache_.store(lineIndex, result);
       return result;
     }
     else if (state == MarkdownState::IN_BLOCKQUOTE)
@@ -266,14 +247,60 @@ SyntaxHighlighter::getHighlightSpans(const std::string &line, int lineIndex,
       std::vector<ColorSpan> result = {
           {0, (int)line.length(), getColorPairValue("MARKDOWN_BLOCKQUOTE"),
            A_NORMAL, 90}};
-      line_cache_[lineIndex] = result;
+      line_cache_.store(lineIndex, result);
       return result;
     }
   }
 
-  std::vector<ColorSpan> result;
+#ifdef TREE_SITTER_ENABLED
+  // Lines outside the prepared viewport are highlighted on their own
+  if (current_ts_query_)
+  {
+    highlightViewport(buffer, lineIndex, lineIndex);
+
+    if (line_cache_.lookup(lineIndex, cached))
+    {
+      return cached;
+    }
+
+    auto provisional_it = provisional_spans_.find(lineIndex);
+    if (provisional_it != provisional_spans_.end())
+    {
+      return provisional_it->second;
+    }
+  }
+#endif
+
+  // Fall back to basic highlighting for lines the tree does not cover
+  std::vector<ColorSpan> result = getBasicHighlightSpans(line);
+
+#ifdef TREE_SITTER_ENABLED
+  if (current_ts_query_)
+  {
+    // Placeholder until the background parse delivers a tree
+    provisional_spans_[lineIndex] = result;
+    return result;
+  }
+#endif
+
+  // Cache the result
+  line_cache_.store(lineIndex, result);
+  return result;
+}
+
+void SyntaxHighlighter::highlightViewport(const GapBuffer &buffer,
+                                          int startLine, int endLine) const
+{
+  const_cast<SyntaxHighlighter *>(this)->applyPendingReload();
 
 #ifdef TREE_SITTER_ENABLED
+  const_cast<SyntaxHighlighter *>(this)->adoptCompiledQueries();
+  if (!current_ts_query_)
+    return;
+
+  const_cast<SyntaxHighlighter *>(this)->adoptParseResult();
+  const_cast<SyntaxHighlighter *>(this)->adoptFullHighlight();
+
   // CRITICAL: Do lazy reparse if needed
   if (tree_needs_reparse_)
   {
@@ -281,40 +308,154 @@ SyntaxHighlighter::getHighlightSpans(const std::string &line, int lineIndex,
     const_cast<SyntaxHighlighter *>(this)->tree_needs_reparse_ = false;
   }
 
-  if (current_ts_query_ && tree_)
+  if (!tree_)
+    return;
+
+  startLine = std::max(0, startLine);
+  endLine = std::min(endLine, buffer.getLineCount() - 1);
+
+  // Narrow the query to the lines that still need spans. Markdown block
+  // states take precedence and are resolved in getHighlightSpans(); fenced
+  // code goes through the query when injections can color it.
+  bool is_markdown = currentLanguage == "Markdown";
+  bool injections = hasInjections();
+  auto needsQuery = [&](int line)
   {
-    try
+    if (line_cache_.contains(line) || provisional_spans_.count(line))
+      return false;
+    if (is_markdown)
     {
-      result = executeTreeSitterQuery(line, lineIndex);
+      MarkdownState state = markdown_states_.stateAt(buffer, line);
+      if ((state == MarkdownState::IN_FENCED_CODE_BLOCK && !injections) ||
+          state == MarkdownState::IN_BLOCKQUOTE)
+        return false;
     }
-    catch (const std::exception &e)
+    return true;
+  };
+
+  int firstLine = -1;
+  int lastLine = -1;
+  auto narrow = [&]()
+  {
+    firstLine = -1;
+    lastLine = -1;
+    for (int i = startLine; i <= endLine; ++i)
     {
-      std::cerr << "Tree-sitter query error on line " << lineIndex << ": "
-                << e.what() << std::endl;
-      result = getBasicHighlightSpans(line);
+      if (needsQuery(i))
+      {
+        if (firstLine < 0)
+          firstLine = i;
+        lastLine = i;
+      }
     }
+  };
+
+  narrow();
+  if (firstLine < 0)
+    return;
+
+  if (injections)
+  {
+    // Visible regions are (re)parsed first; that may uncache more rows
+    const_cast<SyntaxHighlighter *>(this)->refreshInjections(startLine,
+                                                             endLine);
+    narrow();
   }
-#endif
 
-  // Fall back to basic highlighting if no Tree-sitter result
-  if (result.empty())
+  std::vector<std::vector<ColorSpan>> rows(lastLine - firstLine + 1);
+  int coveredFirst = 0;
+  int coveredLast = -1;
+  bool complete = true;
+
+  try
+  {
+    if (!executeViewportQuery(firstLine, lastLine, rows, coveredFirst,
+                              coveredLast, complete))
+      return;
+  }
+  catch (const std::exception &e)
   {
-    result = getBasicHighlightSpans(line);
+    std::cerr << "Tree-sitter query error on lines " << firstLine << "-"
+              << lastLine << ": " << e.what() << std::endl;
+    return;
   }
 
-  // Cache the result
-  line_cache_[lineIndex] = result;
-  return result;
+  overlayInjections(coveredFirst, coveredLast, firstLine, rows);
+
+  bool provisional = tree_stale_ || !complete;
+  for (int i = coveredFirst; i <= coveredLast; ++i)
+  {
+    if (!needsQuery(i))
+      continue;
+
+    if (provisional)
+    {
+      provisional_spans_[i] = std::move(rows[i - firstLine]);
+    }
+    else
+    {
+      line_cache_.store(i, rows[i - firstLine]);
+    }
+  }
+#else
+  (void)buffer;
+  (void)startLine;
+  (void)endLine;
+#endif
 }
+
 void SyntaxHighlighter::updateTreeAfterEdit(
     const GapBuffer &buffer, size_t byte_pos, size_t old_byte_len,
     size_t new_byte_len, uint32_t start_row, uint32_t start_col,
     uint32_t old_end_row, uint32_t old_end_col, uint32_t new_end_row,
     uint32_t new_end_col)
 {
+  // Keep cached lines below the edit by moving them with the text
+  int line_delta = static_cast<int>(new_end_row) - static_cast<int>(old_end_row);
+  if (line_delta > 0)
+  {
+    line_cache_.insertLines(old_end_row + 1, line_delta);
+  }
+  else if (line_delta < 0)
+  {
+    line_cache_.eraseLines(new_end_row + 1, -line_delta);
+  }
+  line_cache_.invalidateRange(start_row, new_end_row);
+
+  // Rescan Markdown block states from the edit until they converge; rows
+  // below the edit whose block state flipped (e.g. a fence was opened) are
+  // recolored
+  if (currentLanguage == "Markdown")
+  {
+    int last_changed = markdown_states_.applyEdit(buffer, start_row,
+                                                  old_end_row, new_end_row);
+    if (last_changed > static_cast<int>(new_end_row))
+    {
+      line_cache_.invalidateRange(new_end_row + 1, last_changed);
+    }
+  }
+
 #ifdef TREE_SITTER_ENABLED
+  // Whatever the workers are parsing or highlighting is now stale; stop
+  // them early
+  tree_version_++;
+  provisional_spans_.clear();
+  if (parse_worker_)
+  {
+    parse_worker_->cancel();
+  }
+  if (highlight_workers_)
+  {
+    highlight_workers_->cancel();
+  }
+
   if (!tree_ || !parser_)
+  {
+    // Still waiting for the first tree: the cancelled job is requeued with
+    // the current text by the next lazy reparse
+    tree_needs_reparse_ = current_ts_language_ != nullptr;
     return;
+  }
 
   // Apply incremental edit to tree structure
   TSInputEdit edit = {.start_byte = (uint32_t)byte_pos,
@@ -325,22 +466,16 @@ void SyntaxHighlighter::updateTreeAfterEdit(
                       .new_end_point = {new_end_row, new_end_col}};
 
   ts_tree_edit(tree_, &edit);
-  tree_version_++;
+  editInjections(edit);
 
   // Mark that tree needs reparsing (will happen on next query)
   tree_needs_reparse_ = true;
-
-  // For very large changes, schedule background reparse
-  if (old_end_row != new_end_row && (new_end_row - old_end_row) > 10)
-  {
-    scheduleBackgroundParse(buffer);
-  }
 #endif
 }
 
 void SyntaxHighlighter::invalidateLineCache(int lineNum)
 {
-  line_cache_.erase(lineNum);
+  line_cache_.invalidate(lineNum);
 }
 
 void SyntaxHighlighter::bufferChanged(const GapBuffer &buffer)
@@ -374,17 +509,9 @@ void SyntaxHighlighter::bufferChanged(const GapBuffer &buffer)
 
 void SyntaxHighlighter::invalidateFromLine(int startLine)
 {
-  // This is for structural changes (insert/delete lines)
-  // Clear only lines >= startLine, but do it efficiently
-
-  auto it = line_cache_.lower_bound(startLine);
-  if (it != line_cache_.end())
-  {
-    line_cache_.erase(it, line_cache_.end());
-  }
-
-  // Don't clear content cache unless change is massive
-  // Let incremental edits handle the tree updates
+  // Drop every cached line >= startLine (e.g. unknown structural changes)
+  line_cache_.invalidateFrom(startLine);
+  markdown_states_.invalidateFrom(startLine);
 }
 
 #ifdef TREE_SITTER_ENABLED
@@ -397,6 +524,18 @@ bool SyntaxHighlighter::initializeTreeSitter()
     return false;
   }
 
+  query_cursor_ = ts_query_cursor_new();
+  injection_parser_ = ts_parser_new();
+  parse_worker_ = std::make_unique<ParseWorker>();
+  parse_worker_->setResultCallback(
+      [this]()
+      {
+        parse_result_ready_ = true;
+        Wakeup::notify();
+      });
+  // Pathological patterns stop here instead of stalling a frame
+  ts_query_cursor_set_match_limit(query_cursor_, QUERY_MATCH_LIMIT);
+
   // Auto-register all languages from generated header
   registerAllLanguages(language_registry_);
 
@@ -408,18 +547,31 @@ bool SyntaxHighlighter::initializeTreeSitter()
 
 void SyntaxHighlighter::cleanupTreeSitter()
 {
-  // Wait for background thread
-  while (is_parsing_)
+  // Joins the workers; a parse in flight is cancelled first
+  parse_worker_.reset();
+  highlight_workers_.reset();
+
+  std::lock_guard<std::mutex> lock(tree_mutex_); // ADD LOCK
+
+  if (query_cursor_)
   {
-    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ts_query_cursor_delete(query_cursor_);
+    query_cursor_ = nullptr;
   }
 
-  std::lock_guard<std::mutex> lock(tree_mutex_); // ADD LOCK
+  current_ts_query_ = nullptr;
+  highlight_query_.reset();
+  pending_highlight_query_ = QueryCache::PendingQuery();
 
-  if (current_ts_query_)
+  clearInjections();
+  injected_languages_.clear();
+  current_injection_query_ = nullptr;
+  injection_query_.reset();
+  pending_injection_query_ = QueryCache::PendingQuery();
+  if (injection_parser_)
   {
-    ts_query_delete(current_ts_query_);
-    current_ts_query_ = nullptr;
+    ts_parser_delete(injection_parser_);
+    injection_parser_ = nullptr;
   }
 
   if (tree_)
@@ -436,7 +588,8 @@ void SyntaxHighlighter::cleanupTreeSitter()
 }
 
 const TSLanguage *
-SyntaxHighlighter::getLanguageFunction(const std::string &parser_name)
+SyntaxHighlighter::getLanguageFunction(const std::string &parser_name,
+                                       const std::string &library)
 {
   auto it = language_registry_.find(parser_name);
   if (it != language_registry_.end())
@@ -444,6 +597,13 @@ SyntaxHighlighter::getLanguageFunction(const std::string &parser_name)
     return it->second(); // Call the function pointer
   }
 
+  // Not linked in: open it as a grammar plugin on first use
+  if (const TSLanguage *language =
+          GrammarLoader::instance().load(parser_name, library))
+  {
+    return language;
+  }
+
   // Enhanced error message showing available languages
   std::cerr << "WARNING: No Tree-sitter language found for: '" << parser_name
             << "'" << std::endl;
@@ -553,6 +713,8 @@ SyntaxHighlighter::loadQueryFromFile(const std::string &query_file_path)
   return query;
 }
 
+#endif
+
 void SyntaxHighlighter::notifyEdit(size_t byte_pos, size_t old_byte_len,
                                    size_t new_byte_len, uint32_t start_row,
                                    uint32_t start_col, uint32_t old_end_row,
@@ -573,6 +735,7 @@ void SyntaxHighlighter::notifyEdit(size_t byte_pos, size_t old_byte_len,
                       .new_end_point = {new_end_row, new_end_col}};
 
   ts_tree_edit(tree_, &edit);
+  editInjections(edit);
 
   // CRITICAL FIX: Mark that we need to reparse on next access
   // This forces updateTree() to be called on next getHighlightSpans()
@@ -582,58 +745,98 @@ void SyntaxHighlighter::notifyEdit(size_t byte_pos, size_t old_byte_len,
 
 void SyntaxHighlighter::invalidateLineRange(int startLine, int endLine)
 {
-  // OPTIMIZATION: Only invalidate affected lines, not entire cache
+  // Only the given lines; structural shifts happen in updateTreeAfterEdit()
+  if (endLine < startLine)
+    return;
+
+  line_cache_.invalidateRange(startLine, endLine);
+}
+
+void SyntaxHighlighter::overlaySpans(std::vector<ColorSpan> &base,
+                                     const std::vector<ColorSpan> &top)
+{
+  if (top.empty())
+    return;
 
-  // For single-line changes, only clear that line
-  if (endLine - startLine <= 3)
+  // The renderer colors a column with the first span containing it, so any
+  // base span under a top span is cut around it
+  std::vector<ColorSpan> merged;
+  merged.reserve(base.size() + top.size() * 2);
+  for (const ColorSpan &span : base)
   {
-    for (int i = startLine; i <= endLine; ++i)
+    int cursor = span.start;
+    for (const ColorSpan &cover : top)
+    {
+      if (cover.end <= cursor)
+        continue;
+      if (cover.start >= span.end)
+        break;
+      if (cover.start > cursor)
+      {
+        ColorSpan piece = span;
+        piece.start = cursor;
+        piece.end = cover.start;
+        merged.push_back(piece);
+      }
+      cursor = std::max(cursor, cover.end);
+      if (cursor >= span.end)
+        break;
+    }
+    if (cursor < span.end)
     {
-      line_cache_.erase(i);
-      line_states_.erase(i);
+      ColorSpan piece = span;
+      piece.start = cursor;
+      merged.push_back(piece);
     }
-    return;
   }
 
-  // For multi-line changes, clear from startLine onwards
-  auto cache_it = line_cache_.lower_bound(startLine);
-  if (cache_it != line_cache_.end())
-  {
-    line_cache_.erase(cache_it, line_cache_.end());
-  }
+  merged.insert(merged.end(), top.begin(), top.end());
+  std::stable_sort(merged.begin(), merged.end(),
+                   [](const ColorSpan &a, const ColorSpan &b)
+                   { return a.start < b.start; });
+  base.swap(merged);
+}
 
-  auto state_it = line_states_.lower_bound(startLine);
-  if (state_it != line_states_.end())
-  {
-    line_states_.erase(state_it, line_states_.end());
-  }
+bool SyntaxHighlighter::hasInjections() const
+{
+#ifdef TREE_SITTER_ENABLED
+  return current_injection_query_ != nullptr;
+#else
+  return false;
+#endif
+}
 
-  // DON'T clear buffer content unless structural change
-  if (endLine - startLine > 10)
+std::vector<uint32_t>
+SyntaxHighlighter::buildLineOffsets(const std::string &content)
+{
+  std::vector<uint32_t> offsets;
+  offsets.push_back(0);
+
+  const char *data = content.data();
+  const char *end = data + content.size();
+  for (const char *p = data;
+       (p = static_cast<const char *>(std::memchr(p, '\n', end - p)));
+       ++p)
   {
-    current_buffer_content_.clear(); // Force reparse on next access
+    offsets.push_back(static_cast<uint32_t>(p - data + 1));
   }
+
+  // Sentinel: the "next line" after the last one starts past a virtual '\n'
+  offsets.push_back(static_cast<uint32_t>(content.size() + 1));
+  return offsets;
 }
 
+#ifdef TREE_SITTER_ENABLED
 void SyntaxHighlighter::updateTree(const GapBuffer &buffer)
 {
-#ifdef TREE_SITTER_ENABLED
   std::string content;
   int lineCount = buffer.getLineCount();
 
-  // Build line offset cache while building content
-  line_byte_offsets_.clear();
-  line_byte_offsets_.reserve(lineCount + 1);
-  line_byte_offsets_.push_back(0); // First line starts at byte 0
-
   for (int i = 0; i < lineCount; i++)
   {
     if (i > 0)
       content += "\n";
     content += buffer.getLine(i);
-
-    // Store the byte offset for the next line
-    line_byte_offsets_.push_back(content.length());
   }
 
   if (content.empty())
@@ -643,156 +846,716 @@ void SyntaxHighlighter::updateTree(const GapBuffer &buffer)
   }
 
   std::lock_guard<std::mutex> lock(tree_mutex_);
-  current_buffer_content_ = content;
 
-  if (!tree_)
+  // A viewport-only tree covers a different text; never reuse it
+  TSTree *old_tree = is_full_parse_ ? tree_ : nullptr;
+
+  // This runs inside a frame: give up past the budget rather than stall input
+  ts_parser_set_timeout_micros(parser_, PARSE_BUDGET_US);
+  TSTree *new_tree = ts_parser_parse_string(parser_, old_tree, content.c_str(),
+                                            content.length());
+  ts_parser_set_timeout_micros(parser_, 0);
+
+  if (!new_tree)
+  {
+    ts_parser_reset(parser_);
+    if (old_tree)
+    {
+      // The edited tree already matches the new text byte-for-byte, so it
+      // keeps serving (slightly stale) spans until the worker is done
+      current_buffer_content_ = content;
+      line_byte_offsets_ = buildLineOffsets(current_buffer_content_);
+      tree_stale_ = true;
+    }
+    else if (tree_)
+    {
+      // A tree that was not edited into this text describes something else;
+      // basic spans stand in until the worker delivers the first real tree
+      ts_tree_delete(tree_);
+      tree_ = nullptr;
+      line_cache_.clear();
+      clearInjections();
+      provisional_spans_.clear();
+    }
+    submitBackgroundParse(std::move(content));
+    return;
+  }
+
+  current_buffer_content_ = std::move(content);
+  line_byte_offsets_ = buildLineOffsets(current_buffer_content_);
+
+  if (old_tree)
   {
-    tree_ = ts_parser_parse_string(parser_, nullptr, content.c_str(),
-                                   content.length());
+    // Recolor exactly the rows whose syntax changed (edited rows were
+    // already invalidated when the edit was recorded)
+    invalidateChangedRanges(old_tree, new_tree);
   }
   else
   {
-    TSTree *old_tree = tree_;
-    tree_ = ts_parser_parse_string(parser_, old_tree, content.c_str(),
-                                   content.length());
-    if (old_tree && tree_)
-    {
-      ts_tree_delete(old_tree);
-    }
+    // Cached spans came from a window parse or the regex fallback
+    line_cache_.clear();
+    clearInjections();
   }
 
-  if (!tree_)
+  if (tree_)
   {
-    std::cerr << "ERROR: Failed to parse tree\n";
+    ts_tree_delete(tree_);
   }
-#endif
+  tree_ = new_tree;
+  is_full_parse_ = true;
+  tree_stale_ = false;
+  provisional_spans_.clear();
+  full_highlight_dirty_ = true;
 }
 
-void SyntaxHighlighter::markViewportLines(int startLine, int endLine) const
+void SyntaxHighlighter::invalidateChangedRanges(const TSTree *old_tree,
+                                                const TSTree *new_tree)
 {
-  priority_lines_.clear();
-  for (int i = startLine; i <= endLine; ++i)
+  uint32_t range_count = 0;
+  TSRange *ranges = ts_tree_get_changed_ranges(old_tree, new_tree, &range_count);
+
+  for (uint32_t i = 0; i < range_count; ++i)
   {
-    priority_lines_.insert(i);
+    uint32_t first_row = ranges[i].start_point.row;
+    uint32_t last_row = ranges[i].end_point.row;
+
+    // A range ending at column 0 stops before that row
+    if (ranges[i].end_point.column == 0 && last_row > first_row)
+      last_row--;
+
+    line_cache_.invalidateRange(first_row, last_row);
   }
+
+  free(ranges);
 }
 
-bool SyntaxHighlighter::isLineHighlighted(int lineIndex) const
+static bool sameRanges(const std::vector<TSRange> &a,
+                       const std::vector<TSRange> &b)
 {
-  return line_cache_.find(lineIndex) != line_cache_.end();
+  return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+                    [](const TSRange &x, const TSRange &y)
+                    {
+                      return x.start_byte == y.start_byte &&
+                             x.end_byte == y.end_byte;
+                    });
 }
 
-std::vector<ColorSpan>
-SyntaxHighlighter::executeTreeSitterQuery(const std::string &line,
-                                          int lineNum) const
+// A point at or after the edit's old end, moved to where the text went
+static TSPoint shiftPointByEdit(TSPoint point, const TSInputEdit &edit)
 {
-  if (!current_ts_query_ || !tree_)
-    return {};
-
-  std::lock_guard<std::mutex> lock(tree_mutex_);
-  std::vector<ColorSpan> spans;
-  TSQueryCursor *cursor = ts_query_cursor_new();
-  TSNode root_node = ts_tree_root_node(tree_);
-
-  int adjusted_line =
-      is_full_parse_ ? lineNum : (lineNum - viewport_start_line_);
-  if (adjusted_line < 0 ||
-      adjusted_line >= ts_node_end_point(root_node).row + 1)
+  if (point.row == edit.old_end_point.row)
   {
-    ts_query_cursor_delete(cursor);
-    return {};
+    return {edit.new_end_point.row,
+            edit.new_end_point.column + point.column -
+                edit.old_end_point.column};
   }
+  return {point.row + edit.new_end_point.row - edit.old_end_point.row,
+          point.column};
+}
 
-  // Calculate byte range for current line
-  uint32_t line_start_byte = 0;
-  uint32_t line_end_byte = 0;
+void SyntaxHighlighter::indexInjectionQuery()
+{
+  injection_content_capture_ = UINT32_MAX;
+  injection_language_capture_ = UINT32_MAX;
+  injection_patterns_.clear();
 
-  std::istringstream content_stream(current_buffer_content_);
-  std::string content_line;
-  int current_line = 0;
+  uint32_t capture_count = ts_query_capture_count(current_injection_query_);
+  for (uint32_t id = 0; id < capture_count; ++id)
+  {
+    uint32_t length;
+    const char *name =
+        ts_query_capture_name_for_id(current_injection_query_, id, &length);
+    std::string capture(name, length);
+    if (capture == "injection.content")
+      injection_content_capture_ = id;
+    else if (capture == "injection.language")
+      injection_language_capture_ = id;
+  }
 
-  while (std::getline(content_stream, content_line) && current_line <= lineNum)
+  // Fixed languages come from (#set! injection.language "name"); which
+  // children belong to the region from the include-*children flags
+  uint32_t pattern_count = ts_query_pattern_count(current_injection_query_);
+  injection_patterns_.resize(pattern_count);
+  for (uint32_t pattern = 0; pattern < pattern_count; ++pattern)
   {
-    if (current_line == lineNum)
+    uint32_t step_count;
+    const TSQueryPredicateStep *steps = ts_query_predicates_for_pattern(
+        current_injection_query_, pattern, &step_count);
+
+    std::vector<std::string> args;
+    for (uint32_t i = 0; i < step_count; ++i)
     {
-      line_end_byte = line_start_byte + content_line.length();
-      break;
+      if (steps[i].type == TSQueryPredicateStepTypeDone)
+      {
+        InjectionPattern &settings = injection_patterns_[pattern];
+        if (args.size() == 3 && args[0] == "set!" &&
+            args[1] == "injection.language")
+        {
+          settings.language = args[2];
+        }
+        else if (args.size() == 2 && args[0] == "set!" &&
+                 args[1] == "injection.include-unnamed-children")
+        {
+          settings.children = InjectedChildren::UNNAMED;
+        }
+        else if (args.size() == 2 && args[0] == "set!" &&
+                 args[1] == "injection.include-children")
+        {
+          settings.children = InjectedChildren::ALL;
+        }
+        args.clear();
+      }
+      else if (steps[i].type == TSQueryPredicateStepTypeString)
+      {
+        uint32_t length;
+        const char *value = ts_query_string_value_for_id(
+            current_injection_query_, steps[i].value_id, &length);
+        args.emplace_back(value, length);
+      }
+      else
+      {
+        args.emplace_back("@");
+      }
     }
-    line_start_byte += content_line.length() + 1;
-    current_line++;
   }
+}
 
-  ts_query_cursor_set_byte_range(cursor, line_start_byte, line_end_byte);
-  ts_query_cursor_exec(cursor, current_ts_query_, root_node);
+std::vector<TSRange>
+SyntaxHighlighter::injectionRanges(TSNode node, InjectedChildren children)
+{
+  TSRange whole = {ts_node_start_point(node), ts_node_end_point(node),
+                   ts_node_start_byte(node), ts_node_end_byte(node)};
+  std::vector<TSRange> ranges;
+  if (whole.start_byte >= whole.end_byte)
+    return ranges;
 
-  TSQueryMatch match;
-  while (ts_query_cursor_next_match(cursor, &match))
+  if (children == InjectedChildren::ALL)
   {
-    for (uint32_t i = 0; i < match.capture_count; i++)
-    {
-      TSQueryCapture capture = match.captures[i];
-      TSNode node = capture.node;
+    ranges.push_back(whole);
+    return ranges;
+  }
 
-      TSPoint start_point = ts_node_start_point(node);
-      TSPoint end_point = ts_node_end_point(node);
+  // Cut excluded children (e.g. the "> " continuation markers of a quoted
+  // paragraph) out of the node's extent
+  TSRange piece = whole;
+  uint32_t child_count = ts_node_child_count(node);
+  for (uint32_t i = 0; i < child_count; ++i)
+  {
+    TSNode child = ts_node_child(node, i);
+    if (children == InjectedChildren::UNNAMED && !ts_node_is_named(child))
+      continue;
 
-      // ORIGINAL: Only process captures starting on current line
-      // Check if this capture affects the current line
-      if (start_point.row <= (uint32_t)lineNum &&
-          end_point.row >= (uint32_t)lineNum)
-      {
-        uint32_t name_length;
-        const char *capture_name_ptr = ts_query_capture_name_for_id(
-            current_ts_query_, capture.index, &name_length);
-        std::string capture_name(capture_name_ptr, name_length);
+    uint32_t child_start = ts_node_start_byte(child);
+    if (child_start > piece.start_byte)
+    {
+      piece.end_byte = child_start;
+      piece.end_point = ts_node_start_point(child);
+      ranges.push_back(piece);
+    }
+    piece.start_byte = std::max(piece.start_byte, ts_node_end_byte(child));
+    piece.start_point = ts_node_end_point(child);
+  }
 
-        int start_col =
-            (start_point.row == (uint32_t)lineNum) ? start_point.column : 0;
-        int end_col = (end_point.row == (uint32_t)lineNum) ? end_point.column
-                                                           : (int)line.length();
+  if (piece.start_byte < whole.end_byte)
+  {
+    piece.end_byte = whole.end_byte;
+    piece.end_point = whole.end_point;
+    ranges.push_back(piece);
+  }
+  return ranges;
+}
 
-        start_col = std::max(0, std::min(start_col, (int)line.length()));
-        end_col = std::max(start_col, std::min(end_col, (int)line.length()));
+const SyntaxHighlighter::InjectedLanguage *
+SyntaxHighlighter::resolveInjectedLanguage(const std::string &name)
+{
+  auto cached = injected_languages_.find(name);
+  if (cached != injected_languages_.end())
+  {
+    // Regions of a language are only created once its query has landed
+    const InjectedLanguage *known = cached->second.get();
+    return known && known->query ? known : nullptr;
+  }
 
-        if (start_col < end_col)
-        {
-          int color_pair = getColorPairForCapture(capture_name);
-          spans.push_back({start_col, end_col, color_pair, 0, 100});
-        }
+  std::string wanted = name;
+  std::transform(wanted.begin(), wanted.end(), wanted.begin(), ::tolower);
+  // Query names like "markdown.inline" map to parser "markdown_inline"
+  std::string parser_name = wanted;
+  std::replace(parser_name.begin(), parser_name.end(), '.', '_');
+  std::replace(parser_name.begin(), parser_name.end(), '-', '_');
+
+  // Fence info strings use extensions ("py"), names ("C++") or parser names
+  const LanguageConfig *config = config_loader_->getLanguageConfig(
+      config_loader_->getLanguageFromExtension(wanted));
+  if (!config)
+  {
+    for (const auto &entry : config_loader_->language_configs_)
+    {
+      std::string config_name = entry.second->name;
+      std::transform(config_name.begin(), config_name.end(),
+                     config_name.begin(), ::tolower);
+      if (config_name == wanted || entry.second->parser_name == parser_name)
+      {
+        config = entry.second.get();
+        break;
       }
     }
   }
 
-  ts_query_cursor_delete(cursor);
-  return spans;
+  std::unique_ptr<InjectedLanguage> injected;
+  if (config && !config->parser_name.empty())
+  {
+    const TSLanguage *language =
+        getLanguageFunction(config->parser_name, config->library);
+    if (language)
+    {
+      // Shared with buffers of that language. Until it compiles the fence
+      // stays flat; adoptInjectedQueries() recolors it once it lands.
+      injected = std::make_unique<InjectedLanguage>();
+      injected->language = language;
+      injected->pending = QueryCache::instance().request(
+          language, config->queries, config->embedded_queries);
+      if (QueryCache::isReady(injected->pending) &&
+          !takeInjectedQuery(*injected))
+      {
+        injected.reset();
+      }
+    }
+  }
+
+  // Unknown names are remembered too, so each is looked up only once
+  const InjectedLanguage *result =
+      injected && injected->query ? injected.get() : nullptr;
+  injected_languages_[name] = std::move(injected);
+  return result;
 }
 
-int SyntaxHighlighter::getColorPairForCapture(
-    const std::string &capture_name) const
+bool SyntaxHighlighter::takeInjectedQuery(InjectedLanguage &injected)
 {
-  static const std::unordered_map<std::string, std::string> capture_to_color = {
-      // Keywords
-      {"keyword", "KEYWORD"},
-      {"keyword.control", "KEYWORD"},
-      {"keyword.function", "KEYWORD"},
-      {"keyword.operator", "KEYWORD"},
-      {"keyword.return", "KEYWORD"},
-      {"keyword.conditional", "KEYWORD"},
-      {"keyword.repeat", "KEYWORD"},
-      {"keyword.import", "KEYWORD"},
-      {"keyword.exception", "KEYWORD"},
+  injected.query = injected.pending.get();
+  injected.pending = QueryCache::PendingQuery();
+  if (!injected.query)
+    return false;
 
-      // Types
-      {"type", "TYPE"},
-      {"type.builtin", "TYPE"},
-      {"type.definition", "TYPE"},
-      {"class", "TYPE"},
-      {"interface", "TYPE"},
+  injected.capture_color_pairs = buildCaptureColorTable(injected.query.get());
+  return true;
+}
 
-      // Functions
-      {"function", "FUNCTION"},
-      {"function.call", "FUNCTION"},
-      {"function.builtin", "FUNCTION"},
+bool SyntaxHighlighter::adoptInjectedQueries()
+{
+  bool adopted = false;
+  for (auto &entry : injected_languages_)
+  {
+    InjectedLanguage *injected = entry.second.get();
+    if (!injected || !QueryCache::isReady(injected->pending))
+      continue;
+
+    if (takeInjectedQuery(*injected))
+    {
+      adopted = true;
+    }
+    else
+    {
+      // No regions exist yet, so the language can simply be forgotten
+      entry.second.reset();
+    }
+  }
+  return adopted;
+}
+
+void SyntaxHighlighter::refreshInjections(int firstLine, int lastLine)
+{
+  if (!current_injection_query_ || !injection_parser_ || !tree_ ||
+      !is_full_parse_)
+    return;
+
+  int tree_lines = static_cast<int>(line_byte_offsets_.size()) - 1;
+  firstLine = std::max(firstLine, 0);
+  lastLine = std::min(lastLine, tree_lines - 1);
+  if (firstLine > lastLine)
+    return;
+
+  injection_clock_++;
+  ts_query_cursor_set_byte_range(query_cursor_, line_byte_offsets_[firstLine],
+                                 line_byte_offsets_[lastLine + 1]);
+  ts_query_cursor_exec(query_cursor_, current_injection_query_,
+                       ts_tree_root_node(tree_));
+
+  TSQueryMatch match;
+  while (ts_query_cursor_next_match(query_cursor_, &match))
+  {
+    InjectionPattern settings;
+    if (match.pattern_index < injection_patterns_.size())
+      settings = injection_patterns_[match.pattern_index];
+    std::string language_name = settings.language;
+
+    TSNode content_node{};
+    bool has_content = false;
+    for (uint16_t i = 0; i < match.capture_count; ++i)
+    {
+      const TSQueryCapture &capture = match.captures[i];
+      if (capture.index == injection_content_capture_)
+      {
+        content_node = capture.node;
+        has_content = true;
+      }
+      else if (capture.index == injection_language_capture_)
+      {
+        uint32_t from = ts_node_start_byte(capture.node);
+        uint32_t to = ts_node_end_byte(capture.node);
+        language_name = current_buffer_content_.substr(from, to - from);
+      }
+    }
+
+    // Patterns without a language (e.g. shebang detection) are not supported
+    if (!has_content || language_name.empty())
+      continue;
+
+    const InjectedLanguage *language = resolveInjectedLanguage(language_name);
+    if (!language)
+      continue;
+
+    TSRange range = {ts_node_start_point(content_node),
+                     ts_node_end_point(content_node),
+                     ts_node_start_byte(content_node),
+                     ts_node_end_byte(content_node)};
+    std::vector<TSRange> included =
+        injectionRanges(content_node, settings.children);
+    if (included.empty())
+      continue;
+
+    // Regions are identified by language and start; edits keep both current
+    auto it = std::find_if(injection_regions_.begin(), injection_regions_.end(),
+                           [&](const InjectionRegion &region)
+                           {
+                             return region.language == language &&
+                                    region.range.start_byte == range.start_byte;
+                           });
+
+    if (it == injection_regions_.end())
+    {
+      if (injection_regions_.size() >= MAX_INJECTION_REGIONS)
+      {
+        auto oldest = std::min_element(
+            injection_regions_.begin(), injection_regions_.end(),
+            [](const InjectionRegion &a, const InjectionRegion &b)
+            { return a.last_used < b.last_used; });
+        if (oldest->tree)
+          ts_tree_delete(oldest->tree);
+        injection_regions_.erase(oldest);
+      }
+
+      InjectionRegion region;
+      region.language = language;
+      region.range = range;
+      region.included = std::move(included);
+      injection_regions_.push_back(std::move(region));
+      it = injection_regions_.end() - 1;
+    }
+    else if (it->range.end_byte != range.end_byte ||
+             !sameRanges(it->included, included))
+    {
+      it->range = range;
+      it->included = std::move(included);
+      it->dirty = true;
+    }
+
+    it->last_used = injection_clock_;
+    if (it->dirty)
+    {
+      parseInjectionRegion(*it);
+    }
+  }
+}
+
+void SyntaxHighlighter::parseInjectionRegion(InjectionRegion &region)
+{
+  if (!ts_parser_set_language(injection_parser_, region.language->language))
+    return;
+
+  // Only the region's bytes are parsed; positions stay document-absolute
+  ts_parser_set_included_ranges(injection_parser_, region.included.data(),
+                                region.included.size());
+  TSTree *tree = ts_parser_parse_string(
+      injection_parser_, region.tree, current_buffer_content_.c_str(),
+      current_buffer_content_.length());
+  if (!tree)
+  {
+    ts_parser_reset(injection_parser_);
+    return;
+  }
+
+  if (region.tree)
+  {
+    invalidateChangedRanges(region.tree, tree);
+    ts_tree_delete(region.tree);
+  }
+  else
+  {
+    // These rows may have been cached before the region had a tree
+    line_cache_.invalidateRange(region.range.start_point.row,
+                                region.range.end_point.row);
+  }
+
+  region.tree = tree;
+  region.dirty = false;
+}
+
+void SyntaxHighlighter::editInjections(const TSInputEdit &edit)
+{
+  for (InjectionRegion &region : injection_regions_)
+  {
+    if (region.tree)
+      ts_tree_edit(region.tree, &edit);
+
+    TSRange &range = region.range;
+    if (edit.start_byte > range.end_byte)
+      continue;
+
+    if (edit.old_end_byte < range.start_byte)
+    {
+      // Entirely before the region: it just moves with the text
+      range.start_byte = range.start_byte - edit.old_end_byte +
+                         edit.new_end_byte;
+      range.start_point = shiftPointByEdit(range.start_point, edit);
+      for (TSRange &piece : region.included)
+      {
+        piece.start_byte =
+            piece.start_byte - edit.old_end_byte + edit.new_end_byte;
+        piece.end_byte = piece.end_byte - edit.old_end_byte + edit.new_end_byte;
+        piece.start_point = shiftPointByEdit(piece.start_point, edit);
+        piece.end_point = shiftPointByEdit(piece.end_point, edit);
+      }
+    }
+    else
+    {
+      // Touches the region; exact bounds are re-read from the next match
+      region.dirty = true;
+    }
+
+    if (range.end_byte >= edit.old_end_byte)
+    {
+      range.end_byte = range.end_byte - edit.old_end_byte + edit.new_end_byte;
+      range.end_point = shiftPointByEdit(range.end_point, edit);
+    }
+  }
+}
+
+void SyntaxHighlighter::clearInjections()
+{
+  for (InjectionRegion &region : injection_regions_)
+  {
+    if (region.tree)
+      ts_tree_delete(region.tree);
+  }
+  injection_regions_.clear();
+}
+
+void SyntaxHighlighter::overlayInjections(
+    int firstLine, int lastLine, int rowsBase,
+    std::vector<std::vector<ColorSpan>> &rows) const
+{
+  if (injection_regions_.empty() || !is_full_parse_)
+    return;
+
+  uint32_t view_start = line_byte_offsets_[firstLine];
+  uint32_t view_end = line_byte_offsets_[lastLine + 1];
+
+  std::vector<std::vector<ColorSpan>> injected(rows.size());
+  bool any = false;
+  for (const InjectionRegion &region : injection_regions_)
+  {
+    if (!region.tree || region.dirty)
+      continue;
+
+    uint32_t start_byte = std::max(view_start, region.range.start_byte);
+    uint32_t end_byte = std::min(view_end, region.range.end_byte);
+    if (start_byte >= end_byte)
+      continue;
+
+    int first_row =
+        std::max<int>(firstLine, region.range.start_point.row);
+    int last_row = std::min<int>(lastLine, region.range.end_point.row);
+    collectCaptureSpans(region.language->query.get(),
+                        region.language->capture_color_pairs,
+                        ts_tree_root_node(region.tree), start_byte, end_byte,
+                        first_row, last_row, 0, rowsBase, injected,
+                        INJECTION_PRIORITY);
+    any = true;
+  }
+
+  if (!any)
+    return;
+
+  for (size_t i = 0; i < rows.size(); ++i)
+  {
+    overlaySpans(rows[i], injected[i]);
+  }
+}
+#endif
+
+void SyntaxHighlighter::markViewportLines(int startLine, int endLine) const
+{
+  auto now = std::chrono::steady_clock::now();
+  scroll_.height = std::max(1, endLine - startLine + 1);
+
+  if (scroll_.top >= 0 && startLine != scroll_.top)
+  {
+    int delta = startLine - scroll_.top;
+    double seconds =
+        std::chrono::duration<double>(now - scroll_.last_move).count();
+    // A pause longer than a second starts a new gesture
+    double speed = seconds > 0.0 && seconds < 1.0
+                       ? std::abs(delta) / seconds
+                       : 0.0;
+
+    scroll_.direction = delta > 0 ? 1 : -1;
+    scroll_.velocity = seconds < 1.0 ? 0.5 * scroll_.velocity + 0.5 * speed
+                                     : speed;
+    scroll_.last_move = now;
+  }
+  else if (scroll_.top < 0)
+  {
+    scroll_.last_move = now;
+  }
+  scroll_.top = startLine;
+}
+
+bool SyntaxHighlighter::prefetchHighlights(const GapBuffer &buffer)
+{
+#ifdef TREE_SITTER_ENABLED
+  // Only against a settled tree: reparsing is the next frame's job, and
+  // spans from a stale tree would not be cached anyway
+  if (!current_ts_query_ || !tree_ || tree_stale_ || tree_needs_reparse_ ||
+      scroll_.top < 0)
+    return false;
+
+  int screens = scroll_.velocity >=
+                        FAST_SCROLL_SCREENS_PER_SEC * scroll_.height
+                    ? 2
+                    : 1;
+  int span = screens * scroll_.height;
+  int lineCount = buffer.getLineCount();
+
+  int first;
+  int last;
+  if (scroll_.direction > 0)
+  {
+    first = scroll_.top + scroll_.height;
+    last = std::min(first + span, lineCount) - 1;
+  }
+  else
+  {
+    last = scroll_.top - 1;
+    first = std::max(0, scroll_.top - span);
+  }
+  if (first > last)
+    return false;
+
+  bool pending = false;
+  for (int i = first; i <= last && !pending; ++i)
+  {
+    pending = !line_cache_.contains(i);
+  }
+  if (!pending)
+    return false;
+
+  highlightViewport(buffer, first, last);
+  return true;
+#else
+  (void)buffer;
+  return false;
+#endif
+}
+
+bool SyntaxHighlighter::isLineHighlighted(int lineIndex) const
+{
+  return line_cache_.contains(lineIndex);
+}
+
+#ifdef TREE_SITTER_ENABLED
+bool SyntaxHighlighter::executeViewportQuery(
+    int firstLine, int lastLine, std::vector<std::vector<ColorSpan>> &rows,
+    int &coveredFirst, int &coveredLast, bool &complete) const
+{
+  if (!current_ts_query_ || !tree_ || !query_cursor_)
+    return false;
+
+  std::lock_guard<std::mutex> lock(tree_mutex_);
+
+  int tree_lines = static_cast<int>(line_byte_offsets_.size()) - 1;
+
+  int first_row = std::max(firstLine, 0);
+  int last_row = std::min(lastLine, tree_lines - 1);
+  if (first_row > last_row)
+    return false;
+
+  coveredFirst = first_row;
+  coveredLast = last_row;
+
+  complete = collectCaptureSpans(
+      current_ts_query_, capture_color_pairs_, ts_tree_root_node(tree_),
+      line_byte_offsets_[first_row], line_byte_offsets_[last_row + 1],
+      first_row, last_row, 0, firstLine, rows, 100);
+  return true;
+}
+
+bool SyntaxHighlighter::collectCaptureSpans(
+    const TSQuery *query, const std::vector<int> &color_pairs, TSNode root,
+    uint32_t start_byte, uint32_t end_byte, int first_row, int last_row,
+    int row_base, int rows_base, std::vector<std::vector<ColorSpan>> &rows,
+    int priority) const
+{
+  return HighlightWorkers::collectSpans(
+      query_cursor_, query, color_pairs, line_byte_offsets_, root, start_byte,
+      end_byte, first_row, last_row, row_base, rows_base, rows, priority);
+}
+
+std::vector<int>
+SyntaxHighlighter::buildCaptureColorTable(const TSQuery *query) const
+{
+  uint32_t capture_count = ts_query_capture_count(query);
+  std::vector<int> color_pairs(capture_count, 0);
+
+  for (uint32_t id = 0; id < capture_count; ++id)
+  {
+    uint32_t name_length;
+    const char *name = ts_query_capture_name_for_id(query, id, &name_length);
+
+    // Captures prefixed with '_' only feed predicates; they carry no color
+    if (name_length == 0 || name[0] == '_')
+      continue;
+
+    color_pairs[id] = getColorPairForCapture(std::string(name, name_length));
+  }
+  return color_pairs;
+}
+
+int SyntaxHighlighter::getColorPairForCapture(
+    const std::string &capture_name) const
+{
+  static const std::unordered_map<std::string, std::string> capture_to_color = {
+      // Keywords
+      {"keyword", "KEYWORD"},
+      {"keyword.control", "KEYWORD"},
+      {"keyword.function", "KEYWORD"},
+      {"keyword.operator", "KEYWORD"},
+      {"keyword.return", "KEYWORD"},
+      {"keyword.conditional", "KEYWORD"},
+      {"keyword.repeat", "KEYWORD"},
+      {"keyword.import", "KEYWORD"},
+      {"keyword.exception", "KEYWORD"},
+
+      // Types
+      {"type", "TYPE"},
+      {"type.builtin", "TYPE"},
+      {"type.definition", "TYPE"},
+      {"class", "TYPE"},
+      {"interface", "TYPE"},
+
+      // Functions
+      {"function", "FUNCTION"},
+      {"function.call", "FUNCTION"},
+      {"function.builtin", "FUNCTION"},
       {"function.method", "FUNCTION"},
       {"method", "FUNCTION"},
 
@@ -868,13 +1631,23 @@ int SyntaxHighlighter::getColorPairForCapture(
       {"markup.quote", "MARKUP_BLOCKQUOTE"},
   };
 
-  auto it = capture_to_color.find(capture_name);
-  if (it != capture_to_color.end())
+  // Hierarchical lookup: keyword.control.return -> keyword.control -> keyword
+  std::string name = capture_name;
+  while (true)
   {
-    return getColorPairValue(it->second);
+    auto it = capture_to_color.find(name);
+    if (it != capture_to_color.end())
+    {
+      return getColorPairValue(it->second);
+    }
+
+    size_t dot = name.rfind('.');
+    if (dot == std::string::npos)
+      break;
+    name.resize(dot);
   }
 
-  // Fallback: hierarchical matching
+  // Fallback: substring matching
   if (capture_name.find("keyword") != std::string::npos)
     return getColorPairValue("KEYWORD");
   if (capture_name.find("type") != std::string::npos)
@@ -992,44 +1765,12 @@ void SyntaxHighlighter::loadBasicRules()
   std::cerr << "Loading basic highlighting rules (fallback mode)" << std::endl;
 }
 
-// Markdown state management (unchanged from original)
+// Markdown block states for a buffer whose edits were not reported (e.g. a
+// full-state undo). Lines are rescanned lazily, only as far as they are drawn.
 void SyntaxHighlighter::updateMarkdownState(const GapBuffer &buffer)
 {
-  if (currentLanguage != "Markdown")
-  {
-    line_states_.clear();
-    return;
-  }
-
-  line_states_.clear();
-  MarkdownState currentState = MarkdownState::DEFAULT;
-
-  int lineCount = buffer.getLineCount();
-  for (int i = 0; i < lineCount; ++i)
-  {
-    std::string line = buffer.getLine(i);
-    line_states_[i] = currentState;
-
-    if (currentState == MarkdownState::DEFAULT)
-    {
-      if (line.rfind("```", 0) == 0)
-      {
-        currentState = MarkdownState::IN_FENCED_CODE_BLOCK;
-      }
-      else if (line.rfind(">", 0) == 0)
-      {
-        line_states_[i] = MarkdownState::IN_BLOCKQUOTE;
-      }
-    }
-    else if (currentState == MarkdownState::IN_FENCED_CODE_BLOCK)
-    {
-      if (line.rfind("```", 0) == 0)
-      {
-        currentState = MarkdownState::DEFAULT;
-      }
-      line_states_[i] = MarkdownState::IN_FENCED_CODE_BLOCK;
-    }
-  }
+  (void)buffer;
+  markdown_states_.clear();
 }
 
 std::vector<std::string> SyntaxHighlighter::getSupportedExtensions() const
@@ -1065,20 +1806,19 @@ void SyntaxHighlighter::debugTreeSitterState() const
 #endif
 }
 
-void SyntaxHighlighter::parseViewportOnly(const GapBuffer &buffer,
-                                          int targetLine)
+void SyntaxHighlighter::scheduleBackgroundParse(const GapBuffer &buffer)
 {
 #ifdef TREE_SITTER_ENABLED
-  if (!parser_ || !current_ts_language_)
+  if (!parse_worker_ || !current_ts_language_)
     return;
 
-  int startLine = std::max(0, targetLine - 50);
-  int endLine = std::min(buffer.getLineCount() - 1, targetLine + 50);
-
   std::string content;
-  for (int i = startLine; i <= endLine; i++)
+  int lineCount = buffer.getLineCount();
+  content.reserve(lineCount * 80);
+
+  for (int i = 0; i < lineCount; i++)
   {
-    if (i > startLine)
+    if (i > 0)
       content += "\n";
     content += buffer.getLine(i);
   }
@@ -1086,41 +1826,291 @@ void SyntaxHighlighter::parseViewportOnly(const GapBuffer &buffer,
   if (content.empty())
     return;
 
-  TSTree *new_tree = ts_parser_parse_string(parser_, nullptr, content.c_str(),
-                                            content.length());
+  submitBackgroundParse(std::move(content));
+#endif
+}
+
+#ifdef TREE_SITTER_ENABLED
+void SyntaxHighlighter::submitBackgroundParse(std::string content)
+{
+  if (!parse_worker_ || !current_ts_language_)
+    return;
 
-  if (new_tree)
+  ParseWorker::Job job;
+  job.content = std::move(content);
+  job.version = tree_version_.load();
+  job.language = current_ts_language_;
+
+  // The edited tree matches this text, so the worker can parse incrementally.
+  // Copies are cheap and may be used from another thread.
+  if (tree_ && is_full_parse_)
   {
-    std::lock_guard<std::mutex> lock(tree_mutex_); // LOCK ADDED
-    if (tree_)
-      ts_tree_delete(tree_);
-    tree_ = new_tree;
-    current_buffer_content_ = content;
-    viewport_start_line_ = startLine;
-    is_full_parse_ = false;
+    job.old_tree = ts_tree_copy(tree_);
   }
-#endif
+
+  // Supersedes (and cancels) any parse still queued or running
+  parse_worker_->submit(std::move(job));
 }
 
-void SyntaxHighlighter::scheduleBackgroundParse(const GapBuffer &buffer)
+bool SyntaxHighlighter::adoptCompiledQueries()
 {
-#ifdef TREE_SITTER_ENABLED
-  if (is_parsing_ || !parser_ || !current_ts_language_)
+  bool adopted = false;
+
+  if (QueryCache::isReady(pending_highlight_query_))
+  {
+    highlight_query_ = pending_highlight_query_.get();
+    pending_highlight_query_ = QueryCache::PendingQuery();
+    current_ts_query_ = highlight_query_.get();
+    capture_color_pairs_.clear();
+    if (current_ts_query_)
+    {
+      capture_color_pairs_ = buildCaptureColorTable(current_ts_query_);
+    }
+    adopted = true;
+  }
+
+  if (QueryCache::isReady(pending_injection_query_))
+  {
+    clearInjections();
+    injection_query_ = pending_injection_query_.get();
+    pending_injection_query_ = QueryCache::PendingQuery();
+    current_injection_query_ = injection_query_.get();
+    if (current_injection_query_)
+    {
+      indexInjectionQuery();
+    }
+    adopted = true;
+  }
+
+  if (adoptInjectedQueries())
+  {
+    adopted = true;
+  }
+
+  if (adopted)
+  {
+    // Rows colored without these queries (basic rules, flat fences)
+    line_cache_.clear();
+    provisional_spans_.clear();
+    if (highlight_workers_)
+    {
+      highlight_workers_->cancel();
+    }
+    full_highlight_dirty_ = true;
+  }
+  return adopted;
+}
+
+bool SyntaxHighlighter::adoptParseResult()
+{
+  parse_result_ready_ = false;
+
+  ParseWorker::Result result;
+  if (!parse_worker_ || !parse_worker_->takeResult(result))
+    return false;
+
+  // Text changed after the job was queued: the tree no longer matches it
+  if (result.version != tree_version_.load())
+  {
+    ts_tree_delete(result.tree);
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(tree_mutex_);
+  if (tree_ && is_full_parse_)
+  {
+    invalidateChangedRanges(tree_, result.tree);
+  }
+  else
+  {
+    line_cache_.clear();
+    clearInjections();
+  }
+
+  if (tree_)
+  {
+    ts_tree_delete(tree_);
+  }
+  tree_ = result.tree;
+  current_buffer_content_ = std::move(result.content);
+  line_byte_offsets_ = buildLineOffsets(current_buffer_content_);
+  is_full_parse_ = true;
+  tree_needs_reparse_ = false;
+  tree_stale_ = false;
+  provisional_spans_.clear();
+  full_highlight_dirty_ = true;
+  return true;
+}
+
+void SyntaxHighlighter::scheduleFullHighlight()
+{
+  // Retried once the tree matches the text again
+  if (!tree_ || !is_full_parse_ || tree_stale_ || tree_needs_reparse_)
     return;
+  full_highlight_dirty_ = false;
 
-  auto now = std::chrono::steady_clock::now();
-  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-                     now - last_parse_time_)
-                     .count();
+  // Markdown block states and injected regions are resolved per viewport
+  if (syntax_mode_ != SyntaxMode::FULL || !highlight_query_ ||
+      hasInjections() || currentLanguage == "Markdown")
+    return;
+
+  if (!highlight_workers_)
+  {
+    unsigned cores = std::thread::hardware_concurrency();
+    unsigned threads = std::clamp(cores > 1 ? cores - 1 : 1u, 1u,
+                                  MAX_HIGHLIGHT_THREADS);
+    highlight_workers_ = std::make_unique<HighlightWorkers>(threads);
+    highlight_workers_->setResultCallback(
+        [this]()
+        {
+          full_results_ready_ = true;
+          Wakeup::notify();
+        });
+  }
 
-  if (elapsed < 500)
+  // Chunks over the rows nothing has colored yet, trimmed to them
+  int tree_lines = static_cast<int>(line_byte_offsets_.size()) - 1;
+  std::vector<HighlightWorkers::Chunk> chunks;
+  for (int first = 0; first < tree_lines; first += FULL_CHUNK_LINES)
+  {
+    int last = std::min(first + FULL_CHUNK_LINES, tree_lines) - 1;
+    int needed_first = -1;
+    int needed_last = -1;
+    for (int row = first; row <= last; ++row)
+    {
+      if (!line_cache_.contains(row))
+      {
+        if (needed_first < 0)
+          needed_first = row;
+        needed_last = row;
+      }
+    }
+    if (needed_first >= 0)
+      chunks.push_back({nullptr, needed_first, needed_last});
+  }
+
+  if (chunks.empty())
+  {
+    highlight_workers_->cancel();
+    return;
+  }
+
+  // Nearest the viewport first, so scrolling away finds colored rows soonest
+  int anchor = std::max(scroll_.top, 0);
+  auto distance = [anchor](const HighlightWorkers::Chunk &chunk)
+  {
+    if (anchor < chunk.first_row)
+      return chunk.first_row - anchor;
+    return anchor > chunk.last_row ? anchor - chunk.last_row : 0;
+  };
+  std::stable_sort(chunks.begin(), chunks.end(),
+                   [&](const HighlightWorkers::Chunk &a,
+                       const HighlightWorkers::Chunk &b)
+                   { return distance(a) < distance(b); });
+
+  for (auto &chunk : chunks)
+  {
+    chunk.tree = ts_tree_copy(tree_);
+  }
+
+  auto snapshot = std::make_shared<HighlightWorkers::Snapshot>();
+  snapshot->query = highlight_query_;
+  snapshot->color_pairs = capture_color_pairs_;
+  snapshot->line_offsets = line_byte_offsets_;
+  snapshot->match_limit = QUERY_MATCH_LIMIT;
+  full_batch_ = highlight_workers_->submit(std::move(snapshot),
+                                           std::move(chunks));
+}
+
+bool SyntaxHighlighter::adoptFullHighlight()
+{
+  if (!highlight_workers_ || !full_results_ready_.exchange(false))
+    return false;
+
+  std::vector<HighlightWorkers::Result> results;
+  if (!highlight_workers_->takeResults(results))
+    return false;
+
+  bool stored = false;
+  for (auto &result : results)
+  {
+    // Rows a truncated query missed are left to the viewport pass
+    if (result.batch != full_batch_ || !result.complete)
+      continue;
+
+    int last_row = result.first_row + static_cast<int>(result.rows.size()) - 1;
+    for (int row = result.first_row; row <= last_row; ++row)
+    {
+      if (line_cache_.contains(row))
+        continue;
+      line_cache_.store(row, result.rows[row - result.first_row]);
+      provisional_spans_.erase(row);
+    }
+    stored = true;
+  }
+  return stored;
+}
+#endif
+
+bool SyntaxHighlighter::adoptBackgroundParse()
+{
+#ifdef TREE_SITTER_ENABLED
+  bool changed = false;
+  if (adoptCompiledQueries())
+  {
+    changed = true;
+  }
+  if (parse_result_ready_ && adoptParseResult())
+  {
+    changed = true;
+  }
+  if (adoptFullHighlight())
+  {
+    changed = true;
+  }
+
+  // Between frames: hand whatever the tree has not colored yet to the
+  // FULL-mode workers
+  if (full_highlight_dirty_)
+  {
+    scheduleFullHighlight();
+  }
+  return changed;
+#else
+  return false;
+#endif
+}
+
+void SyntaxHighlighter::applyBufferDiff(const GapBuffer &buffer)
+{
+#ifdef TREE_SITTER_ENABLED
+  // Pending edits have moved the tree away from current_buffer_content_, and
+  // the text they describe is gone once the buffer was replaced, so there is
+  // nothing incremental to diff against either
+  if (!tree_ || !parser_ || !is_full_parse_ || tree_needs_reparse_ ||
+      current_buffer_content_.empty())
+  {
+    // Start over on the next frame without reusing the edited tree
+    line_cache_.clear();
+    markdown_states_.clear();
+    is_full_parse_ = false;
+    tree_needs_reparse_ = true;
+    tree_version_++;
+    provisional_spans_.clear();
+    if (parse_worker_)
+    {
+      parse_worker_->cancel();
+    }
+    if (highlight_workers_)
+    {
+      highlight_workers_->cancel();
+    }
     return;
+  }
 
-  // Copy content BEFORE starting thread
   std::string content;
   int lineCount = buffer.getLineCount();
-  content.reserve(lineCount * 80);
-
+  content.reserve(current_buffer_content_.size());
   for (int i = 0; i < lineCount; i++)
   {
     if (i > 0)
@@ -1128,58 +2118,57 @@ void SyntaxHighlighter::scheduleBackgroundParse(const GapBuffer &buffer)
     content += buffer.getLine(i);
   }
 
-  if (content.empty())
+  const std::string &old_content = current_buffer_content_;
+  if (content == old_content)
     return;
 
-  is_parsing_ = true;
-  last_parse_time_ = now;
+  // The changed region is everything between the common prefix and suffix
+  size_t limit = std::min(old_content.size(), content.size());
+  size_t prefix = 0;
+  while (prefix < limit && old_content[prefix] == content[prefix])
+    prefix++;
 
-  // NEW: Capture current version
-  uint64_t expected_version = tree_version_.load();
+  size_t suffix = 0;
+  while (suffix < limit - prefix &&
+         old_content[old_content.size() - 1 - suffix] ==
+             content[content.size() - 1 - suffix])
+    suffix++;
 
-  // Create a COPY of parser state to avoid races
-  TSParser *temp_parser = ts_parser_new();
-  if (!ts_parser_set_language(temp_parser, current_ts_language_))
-  {
-    ts_parser_delete(temp_parser);
-    is_parsing_ = false;
-    return;
-  }
+  size_t old_end = old_content.size() - suffix;
+  size_t new_end = content.size() - suffix;
 
-  parse_thread_ = std::thread(
-      [this, content, temp_parser, expected_version]() mutable
-      {
-        TSTree *new_tree = ts_parser_parse_string(
-            temp_parser, nullptr, content.c_str(), content.length());
-
-        if (new_tree)
-        {
-          std::lock_guard<std::mutex> lock(tree_mutex_);
-
-          // NEW: Only update if no newer edits happened
-          if (tree_version_.load() == expected_version)
-          {
-            TSTree *old_tree = tree_;
-            tree_ = new_tree;
-            current_buffer_content_ = std::move(content);
-            is_full_parse_ = true;
+  std::vector<uint32_t> new_offsets = buildLineOffsets(content);
+  auto pointAt = [](const std::vector<uint32_t> &offsets, size_t byte)
+  {
+    auto it = std::upper_bound(offsets.begin(), offsets.end() - 1,
+                               static_cast<uint32_t>(byte));
+    uint32_t row = static_cast<uint32_t>(it - offsets.begin()) - 1;
+    return TSPoint{row, static_cast<uint32_t>(byte - offsets[row])};
+  };
 
-            if (old_tree)
-              ts_tree_delete(old_tree);
-          }
-          else
-          {
-            // Discard stale parse - user has made newer edits
-            ts_tree_delete(new_tree);
-          }
-        }
+  TSPoint start_point = pointAt(line_byte_offsets_, prefix);
+  TSPoint old_end_point = pointAt(line_byte_offsets_, old_end);
+  TSPoint new_end_point = pointAt(new_offsets, new_end);
 
-        ts_parser_delete(temp_parser);
-        is_parsing_ = false;
-        parse_complete_ = true;
-      });
+  updateTreeAfterEdit(buffer, prefix, old_end - prefix, new_end - prefix,
+                      start_point.row, start_point.column, old_end_point.row,
+                      old_end_point.column, new_end_point.row,
+                      new_end_point.column);
+#else
+  (void)buffer;
+  line_cache_.clear();
+  markdown_states_.clear();
+#endif
+}
 
-  parse_thread_.detach();
+void SyntaxHighlighter::waitForQueries()
+{
+#ifdef TREE_SITTER_ENABLED
+  if (pending_highlight_query_.valid())
+    pending_highlight_query_.wait();
+  if (pending_injection_query_.valid())
+    pending_injection_query_.wait();
+  adoptCompiledQueries();
 #endif
 }
 
@@ -1220,7 +2209,11 @@ void SyntaxHighlighter::forceFullReparse(const GapBuffer &buffer)
   if (tree_)
   {
     current_buffer_content_ = std::move(content); // Move instead of copy
+    line_byte_offsets_ = buildLineOffsets(current_buffer_content_);
     is_full_parse_ = true;
+    tree_stale_ = false;
+    provisional_spans_.clear();
+    full_highlight_dirty_ = true;
 
     // Delete old tree AFTER successful parse
     if (old_tree)
@@ -1234,13 +2227,9 @@ void SyntaxHighlighter::forceFullReparse(const GapBuffer &buffer)
   }
 #endif
 
-  // Clear cache ONLY, don't rebuild markdown state unless necessary
+  // Clear cache ONLY; Markdown block states already follow every reported
+  // edit through updateTreeAfterEdit()
   line_cache_.clear();
-
-  if (currentLanguage == "Markdown")
-  {
-    updateMarkdownState(buffer);
-  }
 }
 
 void SyntaxHighlighter::clearAllCache()
@@ -1249,13 +2238,18 @@ void SyntaxHighlighter::clearAllCache()
   line_cache_.clear();
 
   // Clear line states (for Markdown)
-  line_states_.clear();
-
-  // Clear priority lines
-  priority_lines_.clear();
+  markdown_states_.clear();
 
+#ifdef TREE_SITTER_ENABLED
   // CRITICAL: Force tree-sitter content to be marked as stale
   current_buffer_content_.clear();
+  provisional_spans_.clear();
+  clearInjections();
+  if (highlight_workers_)
+  {
+    highlight_workers_->cancel();
+  }
+#endif
 
   // Mark that we need a full reparse
   is_full_parse_ = false;
@@ -3,14 +3,20 @@
 
 #include "src/core/buffer.h"
 #include "src/core/config_manager.h"
+#include "src/features/highlight_cache.h"
+#include "src/features/highlight_workers.h"
 #include "src/features/markdown_state.h"
+#include "src/features/parse_worker.h"
+#include "src/features/query_cache.h"
 #include "src/ui/style_manager.h"
 #include "syntax_config_loader.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <string>
-#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -19,15 +25,6 @@
 #include <tree_sitter/api.h>
 #endif
 
-struct ColorSpan
-{
-  int start;
-  int end;
-  int colorPair;
-  int attribute;
-  int priority;
-};
-
 class SyntaxHighlighter
 {
 public:
@@ -37,19 +34,24 @@ public:
   // Initialize with config directory path
   bool initialize(const std::string &config_directory = "treesitter/");
   void setSyntaxMode(SyntaxMode mode) { syntax_mode_ = mode; }
-  int viewport_start_line_ = 0;
   bool is_full_parse_ = true;
 
   // Core functionality
   void setLanguage(const std::string &extension);
   std::vector<ColorSpan> getHighlightSpans(const std::string &line, int lineNum,
                                            const GapBuffer &buffer) const;
+  // Highlight [startLine, endLine] with a single query pass and cache the
+  // result per line, so per-frame cost depends on the viewport size only
+  void highlightViewport(const GapBuffer &buffer, int startLine,
+                         int endLine) const;
 
   // Buffer update notification for Tree-sitter
   void bufferChanged(const GapBuffer &buffer);
 
   // Get current language info
   std::string getCurrentLanguage() const { return currentLanguage; }
+  // Forget Markdown block states after changes that bypassed
+  // updateTreeAfterEdit(); they are rescanned on demand
   void updateMarkdownState(const GapBuffer &buffer);
   std::vector<std::string> getSupportedExtensions() const;
   std::string computeBufferHash(const GapBuffer &buffer) const
@@ -72,7 +74,12 @@ public:
                   uint32_t start_row, uint32_t start_col, uint32_t old_end_row,
                   uint32_t old_end_col, uint32_t new_end_row,
                   uint32_t new_end_col);
+  // Record the visible range; successive calls give the scroll direction
+  // and speed used by prefetchHighlights()
   void markViewportLines(int startLine, int endLine) const;
+  // Idle-time work: highlight the next screen or two in the direction the
+  // user is scrolling. Bounded to that range; true if anything was queried.
+  bool prefetchHighlights(const GapBuffer &buffer);
   bool isLineHighlighted(int lineIndex) const;
   void debugTreeSitterState() const;
   void updateTreeAfterEdit(const GapBuffer &buffer, size_t byte_pos,
@@ -80,10 +87,20 @@ public:
                            uint32_t start_row, uint32_t start_col,
                            uint32_t old_end_row, uint32_t old_end_col,
                            uint32_t new_end_row, uint32_t new_end_col);
-  void parseViewportOnly(const GapBuffer &buffer, int targetLine);
   void scheduleBackgroundParse(const GapBuffer &buffer);
 
+  // Derive the edit from the last parsed text when the caller cannot describe
+  // it (undo/redo); cache shifting and changed ranges then work as usual
+  void applyBufferDiff(const GapBuffer &buffer);
+
+  // Adopt finished background work (queries, a parse, FULL-mode spans), if
+  // any is waiting; true if cached spans changed
+  bool adoptBackgroundParse();
+
   void forceFullReparse(const GapBuffer &buffer);
+  // Block until the query compiles started by setLanguage() finish and use
+  // them; for benchmarks that must not measure basic-rule frames
+  void waitForQueries();
   void invalidateFromLine(int startLine);
   void clearAllCache();
 
@@ -92,39 +109,157 @@ private:
   std::unique_ptr<SyntaxConfigLoader> config_loader_;
   const LanguageConfig *current_language_config_;
   std::string currentLanguage;
+  std::string current_extension_;
+
+  // Set by the config watcher thread, applied on the UI thread
+  std::atomic<bool> reload_requested_{false};
+  void applyPendingReload();
   SyntaxMode syntax_mode_ = SyntaxMode::VIEWPORT;
   mutable bool tree_initialized_ = false;
   bool parse_pending_ = true;
-  std::thread parse_thread_;
-  std::atomic<bool> is_parsing_{false};
-  std::atomic<bool> parse_complete_{false};
   mutable std::mutex tree_mutex_;
   mutable bool tree_needs_reparse_ = false;
 
   std::atomic<uint64_t> tree_version_{0};
-  void backgroundParse(const GapBuffer &buffer);
 
-  // Markdown state tracking
-  std::map<int, MarkdownState> line_states_;
-  mutable std::map<int, std::vector<ColorSpan>>
-      line_cache_; // Changed from unordered_map
+  // Markdown state tracking; scanned lazily up to the lines being drawn
+  mutable MarkdownBlockStates markdown_states_;
+  mutable HighlightCache line_cache_;
 
   mutable std::string last_buffer_hash_;
   mutable std::unordered_map<int, bool> line_highlight_pending_;
-  mutable std::unordered_set<int> priority_lines_;
-  std::vector<uint32_t> line_byte_offsets_; // Cached byte offsets for each line
 
-  std::chrono::steady_clock::time_point last_parse_time_;
-  static constexpr int PARSE_DEBOUNCE_MS = 500;
+  // Viewport history for prefetching (see markViewportLines)
+  struct ScrollState
+  {
+    int top = -1;
+    int height = 0;
+    int direction = 1;     // +1 down, -1 up; reading down is the default
+    double velocity = 0.0; // Lines per second, smoothed
+    std::chrono::steady_clock::time_point last_move;
+  };
+  mutable ScrollState scroll_;
+  // Prefetch two screens once scrolling is faster than this
+  static constexpr double FAST_SCROLL_SCREENS_PER_SEC = 4.0;
+  // Start byte of each line in current_buffer_content_, plus one past the end
+  std::vector<uint32_t> line_byte_offsets_;
+  static std::vector<uint32_t> buildLineOffsets(const std::string &content);
+  // Cut `base` wherever a `top` span covers it, then merge both (sorted)
+  static void overlaySpans(std::vector<ColorSpan> &base,
+                           const std::vector<ColorSpan> &top);
+  // True when embedded code is colored by its own grammar (injections)
+  bool hasInjections() const;
 
 #ifdef TREE_SITTER_ENABLED
   // Tree-sitter state
   TSParser *parser_;
   TSTree *tree_;
   const TSLanguage *current_ts_language_;
-  TSQuery *current_ts_query_;
+  TSQuery *current_ts_query_;   // Borrowed from highlight_query_
+  TSQueryCursor *query_cursor_; // Reused for every viewport query
+
+  // Compiled queries are shared through QueryCache and built off the UI
+  // thread; until they land, lines get basic highlighting
+  QueryCache::QueryHandle highlight_query_;
+  QueryCache::QueryHandle injection_query_;
+  QueryCache::PendingQuery pending_highlight_query_;
+  QueryCache::PendingQuery pending_injection_query_;
+  // Take over queries whose compile finished; true if any was adopted
+  bool adoptCompiledQueries();
+
+  // Full reparses off the UI thread; finished trees are adopted in
+  // highlightViewport() if no edit happened since they were requested
+  std::unique_ptr<ParseWorker> parse_worker_;
+  std::atomic<bool> parse_result_ready_{false};
+  bool adoptParseResult();
+  void submitBackgroundParse(std::string content);
+
+  // Frame budget for the synchronous reparse and per-query match budget.
+  // Past the parse budget, the edited (not reparsed) tree keeps serving
+  // spans and the worker finishes the parse.
+  static constexpr uint64_t PARSE_BUDGET_US = 8000;
+  static constexpr uint32_t QUERY_MATCH_LIMIT = 256;
+  bool tree_stale_ = false;
+  // SyntaxMode::FULL: between frames, rows nothing has colored yet are
+  // queried in chunks on a worker pool and stored in line_cache_ as they
+  // finish, so scrolling anywhere finds them ready
+  std::unique_ptr<HighlightWorkers> highlight_workers_;
+  std::atomic<bool> full_results_ready_{false};
+  uint64_t full_batch_ = 0;
+  bool full_highlight_dirty_ = false; // Tree changed since the last batch
+  static constexpr int FULL_CHUNK_LINES = 2000;
+  static constexpr unsigned MAX_HIGHLIGHT_THREADS = 4;
+  void scheduleFullHighlight();
+  bool adoptFullHighlight();
+
+  // Spans from a stale tree, a truncated query or the regex fallback while
+  // the first tree is parsed: shown but never cached, dropped whenever tree_
+  // changes
+  mutable std::unordered_map<int, std::vector<ColorSpan>> provisional_spans_;
+
+  // Color pair per capture id of current_ts_query_, resolved once per
+  // compiled query so the hot path is a single array load
+  std::vector<int> capture_color_pairs_;
+  std::vector<int> buildCaptureColorTable(const TSQuery *query) const;
   std::string current_buffer_content_;
 
+  // Language injections (e.g. fenced code in Markdown). Each injected
+  // language is compiled once; each region gets its own tree over just its
+  // byte range, edited with the main tree and (re)parsed only when visible.
+  struct InjectedLanguage
+  {
+    const TSLanguage *language = nullptr;
+    QueryCache::PendingQuery pending; // Valid until the query is adopted
+    QueryCache::QueryHandle query;    // Null while still compiling
+    std::vector<int> capture_color_pairs;
+  };
+  struct InjectionRegion
+  {
+    const InjectedLanguage *language = nullptr;
+    TSRange range;                 // Extent of the @injection.content node
+    std::vector<TSRange> included; // What the grammar actually sees
+    TSTree *tree = nullptr;
+    bool dirty = true; // Edited or moved since it was last parsed
+    uint64_t last_used = 0;
+  };
+  TSQuery *current_injection_query_ = nullptr; // Borrowed from injection_query_
+  TSParser *injection_parser_ = nullptr;
+  uint32_t injection_content_capture_ = UINT32_MAX;
+  uint32_t injection_language_capture_ = UINT32_MAX;
+  // Per-pattern settings from #set! predicates
+  enum class InjectedChildren
+  {
+    NONE,    // Exclude every child node's text (the default)
+    UNNAMED, // injection.include-unnamed-children: drop named children only
+    ALL      // injection.include-children
+  };
+  struct InjectionPattern
+  {
+    std::string language;
+    InjectedChildren children = InjectedChildren::NONE;
+  };
+  std::vector<InjectionPattern> injection_patterns_;
+  static std::vector<TSRange> injectionRanges(TSNode node,
+                                              InjectedChildren children);
+  // Keyed by the name used in the document; unknown names map to null
+  std::unordered_map<std::string, std::unique_ptr<InjectedLanguage>>
+      injected_languages_;
+  std::vector<InjectionRegion> injection_regions_;
+  uint64_t injection_clock_ = 0;
+  static constexpr size_t MAX_INJECTION_REGIONS = 256;
+  static constexpr int INJECTION_PRIORITY = 110;
+
+  void indexInjectionQuery();
+  const InjectedLanguage *resolveInjectedLanguage(const std::string &name);
+  bool takeInjectedQuery(InjectedLanguage &injected);
+  bool adoptInjectedQueries();
+  void refreshInjections(int firstLine, int lastLine);
+  void parseInjectionRegion(InjectionRegion &region);
+  void editInjections(const TSInputEdit &edit);
+  void clearInjections();
+  void overlayInjections(int firstLine, int lastLine, int rowsBase,
+                         std::vector<std::vector<ColorSpan>> &rows) const;
+
   // NEW: Language function registry (auto-populated from generated header)
   std::unordered_map<std::string, const TSLanguage *(*)()> language_registry_;
 
@@ -133,14 +268,33 @@ private:
   // Tree-sitter management methods
   bool initializeTreeSitter();
   void cleanupTreeSitter();
-  const TSLanguage *getLanguageFunction(const std::string &parser_name);
+  // Linked-in grammar, else the shared object from `library` (see
+  // GrammarLoader)
+  const TSLanguage *getLanguageFunction(const std::string &parser_name,
+                                        const std::string &library = "");
   TSQuery *loadQueryFromFile(const std::string &query_file_path);
   void updateTree(const GapBuffer &buffer);
+  void invalidateChangedRanges(const TSTree *old_tree, const TSTree *new_tree);
   void debugParseTree(const std::string &code) const;
 
-  // Query execution
-  std::vector<ColorSpan> executeTreeSitterQuery(const std::string &line,
-                                                int lineNum) const;
+  // Query execution: bucket captures for [firstLine, lastLine] by row.
+  // Returns false if the tree covers none of those lines; otherwise the
+  // covered (absolute) line range is reported through coveredFirst/Last.
+  // `complete` is false when the match limit cut the query short.
+  bool executeViewportQuery(int firstLine, int lastLine,
+                            std::vector<std::vector<ColorSpan>> &rows,
+                            int &coveredFirst, int &coveredLast,
+                            bool &complete) const;
+  // Append colored spans of `query` captures under `root` within
+  // [start_byte, end_byte) and tree rows [first_row, last_row]; tree row r
+  // lands in rows[r + row_base - rows_base]. False if the match limit hit.
+  bool collectCaptureSpans(const TSQuery *query,
+                           const std::vector<int> &color_pairs, TSNode root,
+                           uint32_t start_byte, uint32_t end_byte,
+                           int first_row, int last_row, int row_base,
+                           int rows_base,
+                           std::vector<std::vector<ColorSpan>> &rows,
+                           int priority) const;
   int getColorPairForCapture(const std::string &capture_name) const;
 #endif
 
@@ -1,12 +1,17 @@
 // src/main.cpp
 #include "src/core/config_manager.h"
 #include "src/core/editor.h"
+#include "src/core/wakeup.h"
 #include "src/features/syntax_highlighter.h"
 #include "src/ui/input_handler.h"
+#include "src/ui/render_backend.h"
 #include "src/ui/style_manager.h"
 #include <algorithm>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <filesystem>
+#include <iomanip>
 #include <iostream>
 #include <vector>
 
@@ -15,6 +20,7 @@
 #else
 #include <csignal>
 #include <ncurses.h>
+#include <poll.h>
 #include <termios.h>
 #include <unistd.h>
 #endif
@@ -166,7 +172,172 @@ BenchmarkResult runStartupInteractiveBenchmark(const std::string &filename,
   return result;
 }
 
+struct RenderBenchmarkResult
+{
+  struct Phase
+  {
+    std::string name;
+    int frames = 0;
+    std::chrono::microseconds time{0};
+    HeadlessBackend::Stats stats;
+  };
+
+  int rows = 0;
+  int cols = 0;
+  std::vector<Phase> phases;
+
+  void print(std::ostream &os) const
+  {
+    os << "=== Render Benchmark (" << cols << "x" << rows
+       << ", headless) ===" << std::endl;
+    for (const auto &phase : phases)
+    {
+      int frames = std::max(1, phase.frames);
+      os << std::left << std::setw(14) << phase.name << std::right
+         << std::setw(5) << phase.frames << " frames  " << std::setw(7)
+         << phase.time.count() / frames << "us/frame  " << std::setw(6)
+         << phase.stats.rows / frames << " rows  " << std::setw(7)
+         << phase.stats.cells / frames << " cells  " << std::setw(6)
+         << phase.stats.runs / frames << " runs  " << std::setw(5)
+         << phase.stats.scrolls << " scrolls  " << std::setw(7)
+         << phase.stats.bytes / frames << " bytes/frame" << std::endl;
+    }
+  }
+};
+
+// Render cost without a terminal: the editor draws into a HeadlessBackend,
+// so this runs in CI containers and the numbers do not depend on the TTY
+RenderBenchmarkResult runRenderBenchmark(const std::string &filename,
+                                         bool enable_syntax_highlighting,
+                                         int cols, int rows)
+{
+  RenderBenchmarkResult result;
+  result.rows = rows;
+  result.cols = cols;
+
+  SyntaxHighlighter syntaxHighlighter;
+  SyntaxHighlighter *highlighterPtr = nullptr;
+
+  if (enable_syntax_highlighting)
+  {
+    std::string syntax_dir = ConfigManager::getSyntaxRulesDir();
+    if (syntaxHighlighter.initialize(syntax_dir))
+    {
+      highlighterPtr = &syntaxHighlighter;
+    }
+  }
+
+  Editor editor(highlighterPtr);
+  auto backend = std::make_unique<HeadlessBackend>(rows, cols);
+  HeadlessBackend *screen = backend.get();
+  editor.setRenderBackend(std::move(backend));
+
+  if (!editor.loadFile(filename))
+  {
+    throw std::runtime_error("Failed to load file");
+  }
+
+  // Parse and compile queries up front, so every run colors the same rows
+  // the same way
+  if (highlighterPtr)
+  {
+    syntaxHighlighter.waitForQueries();
+    syntaxHighlighter.forceFullReparse(editor.getBuffer());
+  }
+
+  auto measure = [&](const std::string &name, int frames, auto step)
+  {
+    RenderBenchmarkResult::Phase phase;
+    phase.name = name;
+    screen->resetStats();
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < frames && step(); i++)
+    {
+      editor.display();
+      phase.frames++;
+    }
+    phase.time = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::high_resolution_clock::now() - start);
+
+    phase.stats = screen->stats();
+    result.phases.push_back(phase);
+  };
+
+  measure("first frame", 1, [] { return true; });
+  measure("cursor down", 200,
+          [&]
+          {
+            editor.moveCursorDown();
+            return true;
+          });
+  measure("page down", 200,
+          [&]
+          {
+            int before = editor.captureSnapshot().cursorLine;
+            editor.pageDown();
+            return editor.captureSnapshot().cursorLine != before;
+          });
+  measure("wheel up", 200,
+          [&]
+          {
+            int before = editor.captureSnapshot().viewportTop;
+            editor.scrollUp();
+            return editor.captureSnapshot().viewportTop != before;
+          });
+  measure("redraw", 50, [] { return true; });
+
+  return result;
+}
+
+// How many input events each frame absorbed, for --input-stats
+struct InputFrameStats
+{
+  uint64_t frames = 0;
+  uint64_t events = 0;
+  int max_events = 0;    // Largest burst drawn as one frame
+  uint64_t capped = 0;   // Frames drawn with input still waiting
+  int histogram[5] = {}; // Events per frame: 1, 2-3, 4-7, 8-15, 16+
+
+  void record(int frame_events, bool hit_cap)
+  {
+    frames++;
+    events += frame_events;
+    max_events = std::max(max_events, frame_events);
+    capped += hit_cap;
+    int bucket = 0;
+    while (bucket < 4 && frame_events >= (2 << bucket))
+      bucket++;
+    histogram[bucket]++;
+  }
+
+  void print(std::ostream &os) const
+  {
+    os << "=== Input Stats ===" << std::endl;
+    os << "Frames:            " << frames << std::endl;
+    os << "Events:            " << events << std::endl;
+    os << "Events per frame:  " << std::fixed << std::setprecision(2)
+       << (frames ? double(events) / frames : 0.0) << " avg, " << max_events
+       << " max" << std::endl;
+    os << "Capped frames:     " << capped << std::endl;
+    static const char *labels[5] = {"1", "2-3", "4-7", "8-15", "16+"};
+    for (int i = 0; i < 5; i++)
+    {
+      os << "  " << std::left << std::setw(5) << labels[i] << std::right
+         << std::setw(8) << histogram[i] << " frames" << std::endl;
+    }
+  }
+};
+
+// A burst of waiting input is applied before the next frame is drawn, up to
+// these limits, so the screen keeps moving during a long paste or key repeat
+const int MAX_EVENTS_PER_FRAME = 256;
+const std::chrono::milliseconds MAX_BURST_TIME(16);
+
 void flushInputQueue();
+int pendingKey();
+bool waitForEvents();
+bool inputWaiting();
 
 int main(int argc, char *argv[])
 {
@@ -181,6 +352,16 @@ int main(int argc, char *argv[])
         << std::endl;
     std::cerr << "  --bench-file-only        Benchmark only file loading"
               << std::endl;
+    std::cerr << "  --bench-render           Benchmark rendering on a headless "
+                 "screen (no TTY)"
+              << std::endl;
+    std::cerr << "  --bench-size=COLSxROWS   Screen size for --bench-render "
+                 "(default 120x40)"
+              << std::endl;
+    std::cerr << "\nDiagnostics:" << std::endl;
+    std::cerr << "  --input-stats            Print input events per frame on "
+                 "exit"
+              << std::endl;
     return 1;
   }
 
@@ -194,6 +375,9 @@ int main(int argc, char *argv[])
   bool quit_immediately =
       std::any_of(args.begin(), args.end(),
                   [](const auto &arg) { return arg == "--quit"; });
+  bool input_stats =
+      std::any_of(args.begin(), args.end(),
+                  [](const auto &arg) { return arg == "--input-stats"; });
 
   //   Bechmark
   bool bench_startup = std::any_of(args.begin(), args.end(), [](const auto &arg)
@@ -202,6 +386,20 @@ int main(int argc, char *argv[])
       std::any_of(args.begin(), args.end(), [](const auto &arg)
                   { return arg == "--bench-startup-nosyntax"; });
 
+  bool bench_render = std::any_of(args.begin(), args.end(), [](const auto &arg)
+                                  { return arg == "--bench-render"; });
+  int bench_cols = 120;
+  int bench_rows = 40;
+  for (const auto &arg : args)
+  {
+    if (arg.rfind("--bench-size=", 0) == 0 &&
+        std::sscanf(arg.c_str() + 13, "%dx%d", &bench_cols, &bench_rows) != 2)
+    {
+      std::cerr << "Invalid " << arg << ", expected COLSxROWS" << std::endl;
+      return 1;
+    }
+  }
+
   std::string filename = std::filesystem::absolute(argv[1]).string();
 
   // Initialize config
@@ -212,6 +410,23 @@ int main(int argc, char *argv[])
   ConfigManager::copyProjectFilesToConfig();
   ConfigManager::loadConfig();
 
+  if (bench_render)
+  {
+    try
+    {
+      RenderBenchmarkResult result = runRenderBenchmark(
+          filename, !force_no_highlighting, bench_cols, bench_rows);
+
+      result.print(std::cerr);
+      return 0;
+    }
+    catch (const std::exception &e)
+    {
+      std::cerr << "Benchmark failed: " << e.what() << std::endl;
+      return 1;
+    }
+  }
+
   if (bench_startup || bench_startup_nosyntax)
   {
     try
@@ -292,6 +507,7 @@ int main(int argc, char *argv[])
     std::string syntax_dir = ConfigManager::getSyntaxRulesDir();
     if (syntaxHighlighter.initialize(syntax_dir))
     {
+      syntaxHighlighter.setSyntaxMode(syntax_mode);
       highlighterPtr = &syntaxHighlighter;
     }
     else
@@ -338,6 +554,12 @@ int main(int argc, char *argv[])
     }
   }
 
+  // Truecolor output bypasses the curses palette; curses keeps the input
+  if (ConfigManager::getRenderer() == "truecolor")
+  {
+    editor.setRenderBackend(std::make_unique<AnsiBackend>());
+  }
+
   setupMouse();
 
   if (highlighterPtr)
@@ -348,8 +570,7 @@ int main(int argc, char *argv[])
   InputHandler inputHandler(editor);
   editor.setCursorMode();
   editor.display();
-  wnoutrefresh(stdscr);
-  doupdate();
+  editor.flushScreen();
   curs_set(1); // Ensure cursor is visible
 
   // Handle --quit for testing
@@ -363,10 +584,6 @@ int main(int argc, char *argv[])
     return 0;
   }
 
-  if (highlighterPtr)
-  {
-    highlighterPtr->scheduleBackgroundParse(editor.getBuffer());
-  }
   // Start config watching
   if (!ConfigManager::startWatchingConfig())
   {
@@ -376,53 +593,96 @@ int main(int argc, char *argv[])
   // Main loop
   int key;
   bool running = true;
+  InputFrameStats frame_stats;
   while (running)
   {
     if (ConfigManager::isReloadPending())
     {
-      curs_set(0); // Hide cursor
+      editor.invalidateFrame(); // The theme reload cleared the screen
+      curs_set(0);              // Hide cursor
       editor.display();
-      wnoutrefresh(stdscr);
-      doupdate();
+      editor.flushScreen();
       editor.positionCursor(); // Position AFTER flush
       curs_set(1);             // Show cursor
     }
 
+    // OSC 52 copies are written between frames, never mid-update
+    editor.flushClipboardOutput();
+
+    // Background parses land between keys; repaint only recolored rows
+    if (editor.refreshHighlights())
+    {
+      curs_set(0);
+      editor.flushScreen();
+      editor.positionCursor();
+      curs_set(1);
+    }
+
+    // Nothing is drawn here: spans for the next screen are ready before the
+    // scroll that needs them. Only while idle; a key that is already waiting
+    // (held PgDn) should not pay for a screen of queries first.
+    if (!inputWaiting())
+    {
+      editor.prefetchHighlights();
+    }
+
+#ifdef _WIN32
     key = getch();
+#else
+    // Sleep until a key, a resize or a worker result arrives
+    if (!waitForEvents())
+    {
+      break; // The terminal went away
+    }
+    key = pendingKey();
+#endif
+    if (key == ERR)
+      continue;
+
+    // Apply every event that is already waiting, then draw once. Key repeat
+    // and pastes no longer queue up a frame per key, so the frame rate
+    // follows what the terminal can take rather than the input rate.
+    bool redraw = false;
+    int events = 0;
+    auto burst_start = std::chrono::steady_clock::now();
+    while (key != ERR)
+    {
+      events++;
+      InputHandler::KeyResult result = inputHandler.handleKey(key);
+      if (result == InputHandler::KeyResult::QUIT)
+      {
+        running = false;
+        break;
+      }
+      if (result == InputHandler::KeyResult::REDRAW ||
+          result == InputHandler::KeyResult::HANDLED)
+      {
+        redraw = true;
+      }
 
-    // if (key == 'q' || key == 'Q')
-    // {
-    //   //   if (editor.getMode() == EditorMode::NORMAL)
-    //   //   {
-    //   running = false;
-    //   continue;
-    //   //   }
-    // }
+      if (events >= MAX_EVENTS_PER_FRAME ||
+          std::chrono::steady_clock::now() - burst_start >= MAX_BURST_TIME)
+      {
+        break; // Draw now; the rest is picked up next iteration
+      }
+      key = pendingKey();
+    }
 
-    InputHandler::KeyResult result = inputHandler.handleKey(key);
+    // Drags and wheel scrolls in the burst collapse into one update
+    if (inputHandler.flushMouse())
+    {
+      redraw = true;
+    }
 
-    switch (result)
+    if (running && redraw)
     {
-    case InputHandler::KeyResult::QUIT:
-      running = false;
-      break;
-    case InputHandler::KeyResult::REDRAW:
-    case InputHandler::KeyResult::HANDLED:
       curs_set(0); // Hide during render
       editor.display();
-      wnoutrefresh(stdscr);
-      doupdate();
+      editor.flushScreen();
       editor.positionCursor(); // Position AFTER flush
       curs_set(1);             // Show immediately
-      break;
-    case InputHandler::KeyResult::NOT_HANDLED:
-      //   std::cerr << "Input not handled" << std::endl;
-      break;
+      frame_stats.record(events, key != ERR);
     }
-    // if (result != InputHandler::KeyResult::NOT_HANDLED)
-    // {
-    //   doupdate();
-    // }
   }
 
   // Cleanup
@@ -430,6 +690,11 @@ int main(int argc, char *argv[])
   attrset(A_NORMAL);
   curs_set(1);
   endwin();
+
+  if (input_stats)
+  {
+    frame_stats.print(std::cerr);
+  }
   return 0;
 }
 
@@ -455,7 +720,10 @@ bool initializeNcurses()
   meta(stdscr, TRUE);
   intrflush(stdscr, FALSE);
 #else
-  timeout(50);
+  // Never block in getch(); the main loop waits in poll() instead
+  nodelay(stdscr, TRUE);
+  Wakeup::initialize();
+  Wakeup::watchResize();
 #endif
 
   if (!has_colors())
@@ -514,15 +782,75 @@ void flushInputQueue()
   {
     // Drain all pending input
   }
+#ifdef _WIN32
   nodelay(stdscr, FALSE); // Restore blocking mode
-  timeout(50);            // Restore your timeout
+#endif
+}
+
+// Next key if one is already waiting, ERR otherwise
+int pendingKey()
+{
+#ifdef _WIN32
+  nodelay(stdscr, TRUE);
+  int key = getch();
+  nodelay(stdscr, FALSE);
+  return key;
+#else
+  return getch(); // stdscr is in nodelay mode
+#endif
+}
+
+#ifndef _WIN32
+// Block until stdin is readable or Wakeup::notify() was called. False once
+// stdin is closed.
+bool waitForEvents()
+{
+  pollfd fds[2] = {{STDIN_FILENO, POLLIN, 0}, {Wakeup::fd(), POLLIN, 0}};
+  int count = Wakeup::fd() >= 0 ? 2 : 1;
+
+  if (poll(fds, count, -1) < 0)
+    return true; // EINTR: a signal handler ran, look around and wait again
+
+  if (count > 1 && (fds[1].revents & POLLIN))
+    Wakeup::clear();
+
+  return !(fds[0].revents & (POLLHUP | POLLERR | POLLNVAL)) ||
+         (fds[0].revents & POLLIN);
+}
+#endif
+
+// A key is already readable, so the loop is not about to go idle
+bool inputWaiting()
+{
+#ifdef _WIN32
+  return false;
+#else
+  pollfd stdin_fd = {STDIN_FILENO, POLLIN, 0};
+  return poll(&stdin_fd, 1, 0) > 0 && (stdin_fd.revents & POLLIN);
+#endif
 }
 
 void setupMouse()
 {
   mousemask(ALL_MOUSE_EVENTS | REPORT_MOUSE_POSITION, NULL);
+  // Deliver presses and releases as they happen. Waiting to merge them into
+  // clicks held back the press that starts a drag, and the motion behind
+  // it; Editor::handleMouse treats a release where the press was as a click.
+  mouseinterval(0);
 #ifndef _WIN32
-  printf("\033[?1003h");
+  // SGR (1006) reports carry coordinates past column 223. Curses decodes
+  // them when terminfo says the terminal sends them (xterm); otherwise the
+  // input handler parses what follows "ESC [ <".
+  const char *kmous = tigetstr(const_cast<char *>("kmous"));
+  if (!kmous || kmous == reinterpret_cast<char *>(-1) ||
+      std::strcmp(kmous, "\033[<") != 0)
+  {
+    define_key("\033[<", InputHandler::KEY_SGR_MOUSE);
+  }
+
+  // Report motion only while a button is held (1002, not 1003), so moving
+  // the pointer across the window does not wake the main loop
+  printf("\033[?1002h\033[?1006h");
   fflush(stdout);
 #endif
 }
@@ -530,7 +858,7 @@ void setupMouse()
 void cleanupMouse()
 {
 #ifndef _WIN32
-  printf("\033[?1003l");
+  printf("\033[?1006l\033[?1002l");
   fflush(stdout);
 #endif
 }
\ No newline at end of file
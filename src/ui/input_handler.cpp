@@ -31,9 +31,16 @@ InputHandler::InputHandler(Editor &editor)
 InputHandler::KeyResult InputHandler::handleKey(int key)
 {
   // Handle special events first
-  if (key == KEY_MOUSE && mouse_enabled_)
+  if ((key == KEY_MOUSE || key == KEY_SGR_MOUSE) && mouse_enabled_)
   {
-    return handleMouseEvent();
+    return handleMouseEvent(key);
+  }
+
+  // Drags and scrolls held back for coalescing happened before this key
+  if (flushMouse())
+  {
+    KeyResult result = handleKey(key);
+    return result == KeyResult::NOT_HANDLED ? KeyResult::REDRAW : result;
   }
 
   if (key == KEY_RESIZE)
@@ -302,15 +309,132 @@ bool InputHandler::handleEditingKey(int key)
   }
 }
 
-InputHandler::KeyResult InputHandler::handleMouseEvent()
+InputHandler::KeyResult InputHandler::handleMouseEvent(int key)
 {
   MEVENT event;
-  if (GETMOUSE_FUNC(&event) == OK)
+  bool valid = key == KEY_MOUSE ? GETMOUSE_FUNC(&event) == OK
+                                : readSgrMouse(event);
+  if (!valid)
+    return KeyResult::NOT_HANDLED;
+
+  const mmask_t button1 = BUTTON1_PRESSED | BUTTON1_RELEASED | BUTTON1_CLICKED;
+  if ((event.bstate & REPORT_MOUSE_POSITION) && !(event.bstate & button1))
   {
-    editor_.handleMouse(event);
-    return KeyResult::REDRAW;
+    // Motion only matters while dragging out a selection, and then only
+    // where the pointer ended up
+    if (!editor_.isSelecting)
+      return KeyResult::NOT_HANDLED;
+    drag_event_ = event;
+    drag_pending_ = true;
+    return KeyResult::HANDLED;
   }
-  return KeyResult::NOT_HANDLED;
+
+  if (event.bstate & (BUTTON4_PRESSED | BUTTON5_PRESSED))
+  {
+    wheel_notches_ += (event.bstate & BUTTON5_PRESSED) ? 1 : -1;
+    return KeyResult::HANDLED;
+  }
+
+  // Clicks and releases see the drag and scroll that came before them
+  flushMouse();
+  editor_.handleMouse(event);
+  return KeyResult::REDRAW;
+}
+
+bool InputHandler::flushMouse()
+{
+  bool changed = wheel_notches_ != 0 || drag_pending_;
+
+  // One scroll for the net wheel movement, in the editor's per-notch steps
+  for (; wheel_notches_ < 0; wheel_notches_++)
+    editor_.scrollUp();
+  for (; wheel_notches_ > 0; wheel_notches_--)
+    editor_.scrollDown();
+
+  // After scrolling, so the drag maps to the rows now on screen
+  if (drag_pending_)
+  {
+    drag_pending_ = false;
+    editor_.handleMouse(drag_event_);
+  }
+  return changed;
+}
+
+bool InputHandler::readSgrMouse(MEVENT &event)
+{
+#ifdef _WIN32
+  (void)event;
+  return false; // PDCurses decodes mouse input itself
+#else
+  // The rest of "ESC [ < button ; x ; y M|m" follows; give it a moment in
+  // case it arrives in a later packet, then go back to the main loop's
+  // non-blocking reads
+  timeout(50);
+  int params[3] = {0, 0, 0};
+  int count = 0;
+  int final = ERR;
+  for (int i = 0; i < 32; i++)
+  {
+    int ch = getch();
+    if (ch >= '0' && ch <= '9' && count < 3)
+    {
+      params[count] = params[count] * 10 + (ch - '0');
+    }
+    else if (ch == ';' && count < 2)
+    {
+      count++;
+    }
+    else
+    {
+      final = ch;
+      break;
+    }
+  }
+  nodelay(stdscr, TRUE);
+
+  if ((final != 'M' && final != 'm') || count != 2)
+    return false;
+
+  int button = params[0];
+  event = MEVENT{};
+  event.x = params[1] - 1;
+  event.y = params[2] - 1;
+
+  if (button & 64)
+  {
+    event.bstate = (button & 1) ? BUTTON5_PRESSED : BUTTON4_PRESSED;
+  }
+  else if (button & 32)
+  {
+    event.bstate = REPORT_MOUSE_POSITION;
+  }
+  else
+  {
+    bool press = final == 'M';
+    switch (button & 3)
+    {
+    case 0:
+      event.bstate = press ? BUTTON1_PRESSED : BUTTON1_RELEASED;
+      break;
+    case 1:
+      event.bstate = press ? BUTTON2_PRESSED : BUTTON2_RELEASED;
+      break;
+    case 2:
+      event.bstate = press ? BUTTON3_PRESSED : BUTTON3_RELEASED;
+      break;
+    default:
+      return false;
+    }
+  }
+
+  if (button & 4)
+    event.bstate |= BUTTON_SHIFT;
+  if (button & 8)
+    event.bstate |= BUTTON_ALT;
+  if (button & 16)
+    event.bstate |= BUTTON_CTRL;
+  return true;
+#endif
 }
 
 InputHandler::KeyResult InputHandler::handleResizeEvent()
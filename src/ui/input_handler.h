@@ -34,12 +34,28 @@ public:
   // Enable/disable specific key categories
   void setMouseEnabled(bool enabled) { mouse_enabled_ = enabled; }
 
+  // Drags and wheel scrolls are held back so a burst of them costs one
+  // update; apply them once the waiting input is read, before drawing.
+  // Returns true if the editor changed.
+  bool flushMouse();
+
+  // Returned for "ESC [ <" when curses does not decode SGR (1006) mouse
+  // reports itself, i.e. when terminfo describes X10 reports (screen, tmux)
+  static constexpr int KEY_SGR_MOUSE = KEY_MAX + 1;
+
 private:
   Editor &editor_;
   bool mouse_enabled_;
 
+  // Latest drag position and net wheel notches (down is positive) since
+  // the last flushMouse()
+  bool drag_pending_ = false;
+  MEVENT drag_event_{};
+  int wheel_notches_ = 0;
+
   // Special input types
-  KeyResult handleMouseEvent();
+  KeyResult handleMouseEvent(int key);
+  bool readSgrMouse(MEVENT &event);
   KeyResult handleResizeEvent();
 
   // Movement and editing
@@ -0,0 +1,428 @@
+// src/ui/render_backend.cpp
+#include "render_backend.h"
+
+#include "src/ui/style_manager.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#ifdef _WIN32
+#include <curses.h>
+#else
+#include <ncurses.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+// Shift rows top..bottom of a row-major grid up by `count` (down if
+// negative), filling the exposed rows with `fill`
+template <typename Grid, typename T>
+void shiftRows(Grid &grid, size_t width, int top, int bottom, int count,
+               const T &fill)
+{
+  auto first = grid.begin() + top * width;
+  auto last = grid.begin() + (bottom + 1) * width;
+  size_t moved = std::abs(count) * width;
+  if (count > 0)
+  {
+    std::copy(first + moved, last, first);
+    std::fill(last - moved, last, fill);
+  }
+  else
+  {
+    std::copy_backward(first, last - moved, last);
+    std::fill(first, first + moved, fill);
+  }
+}
+
+// ESC [ top ; bottom r, ESC [ n S (up) or T (down), ESC [ r
+std::string scrollSequence(int top, int bottom, int count)
+{
+  return "\x1b[" + std::to_string(top + 1) + ";" + std::to_string(bottom + 1) +
+         "r\x1b[" + std::to_string(std::abs(count)) + (count > 0 ? "S" : "T") +
+         "\x1b[r";
+}
+
+bool validScroll(int top, int bottom, int count, int rows)
+{
+  return top >= 0 && bottom < rows && top < bottom && count != 0 &&
+         std::abs(count) <= bottom - top;
+}
+} // namespace
+
+int CursesBackend::rows() const { return getmaxy(stdscr); }
+
+int CursesBackend::cols() const { return getmaxx(stdscr); }
+
+void CursesBackend::drawRow(int row, const RenderRow &content)
+{
+  move(row, 0);
+
+  // One attribute change and one write per run, not per character
+  const char *text = content.text.data();
+  for (const auto &run : content.runs)
+  {
+    int pair =
+        run.colorPair >= 0 && run.colorPair < COLOR_PAIRS ? run.colorPair : 0;
+    attr_t attr = COLOR_PAIR(pair);
+    if (run.flags & STYLE_BOLD)
+      attr |= A_BOLD;
+    if (run.flags & STYLE_DIM)
+      attr |= A_DIM;
+    if (run.flags & STYLE_UNDERLINE)
+      attr |= A_UNDERLINE;
+    if (run.flags & STYLE_REVERSE)
+      attr |= A_REVERSE;
+#ifdef A_ITALIC
+    if (run.flags & STYLE_ITALIC)
+      attr |= A_ITALIC;
+#endif
+
+    attrset(attr);
+    waddnstr(stdscr, text, run.length);
+    text += run.length;
+  }
+
+  attrset(COLOR_PAIR(0));
+  if (static_cast<int>(content.text.length()) < getmaxx(stdscr))
+    clrtoeol();
+}
+
+void CursesBackend::moveCursor(int row, int col) { move(row, col); }
+
+bool CursesBackend::scrollRows(int top, int bottom, int count)
+{
+  if (!validScroll(top, bottom, count, getmaxy(stdscr)))
+    return false;
+
+  // idlok lets doupdate() move the lines with the terminal's scroll region
+  // or insert/delete line instead of repainting them
+  idlok(stdscr, TRUE);
+  setscrreg(top, bottom);
+  scrollok(stdscr, TRUE);
+  wscrl(stdscr, count);
+  scrollok(stdscr, FALSE);
+  setscrreg(0, getmaxy(stdscr) - 1);
+  return true;
+}
+
+void CursesBackend::flush()
+{
+  wnoutrefresh(stdscr);
+  doupdate();
+}
+
+HeadlessBackend::HeadlessBackend(int rows, int cols) { resize(rows, cols); }
+
+void HeadlessBackend::resize(int rows, int cols)
+{
+  rows_ = std::max(1, rows);
+  cols_ = std::max(1, cols);
+  screen_.assign(rows_, std::string(cols_, ' '));
+}
+
+void HeadlessBackend::drawRow(int row, const RenderRow &content)
+{
+  if (row < 0 || row >= rows_)
+    return;
+
+  int length = std::min(static_cast<int>(content.text.length()), cols_);
+  std::string &line = screen_[row];
+  line.replace(0, length, content.text, 0, length);
+  std::fill(line.begin() + length, line.end(), ' ');
+
+  stats_.rows++;
+  stats_.cells += length;
+  stats_.runs += content.runs.size();
+
+  // ESC [ row ; 1 H
+  stats_.bytes += 5 + std::to_string(row + 1).length();
+  for (const auto &run : content.runs)
+  {
+    // ESC [ 0 {;flag} ; 38;5;pair m
+    int flags = 0;
+    for (uint16_t bits = run.flags; bits; bits &= bits - 1)
+      flags++;
+    stats_.bytes += 10 + 2 * flags + std::to_string(run.colorPair).length();
+  }
+  stats_.bytes += length;
+  if (length < cols_)
+    stats_.bytes += 3; // ESC [ K
+}
+
+void HeadlessBackend::moveCursor(int row, int col)
+{
+  cursor_row_ = row;
+  cursor_col_ = col;
+}
+
+bool HeadlessBackend::scrollRows(int top, int bottom, int count)
+{
+  if (!validScroll(top, bottom, count, rows_))
+    return false;
+
+  shiftRows(screen_, 1, top, bottom, count, std::string(cols_, ' '));
+  stats_.scrolls++;
+  stats_.bytes += scrollSequence(top, bottom, count).length();
+  return true;
+}
+
+AnsiBackend::AnsiBackend(int fd) : fd_(fd) {}
+
+int AnsiBackend::rows() const { return getmaxy(stdscr); }
+
+int AnsiBackend::cols() const { return getmaxx(stdscr); }
+
+void AnsiBackend::resizeBuffers(int rows, int cols)
+{
+  rows = std::max(0, rows);
+  cols = std::max(0, cols);
+  if (rows == rows_ && cols == cols_)
+    return;
+
+  rows_ = rows;
+  cols_ = cols;
+  front_.assign(static_cast<size_t>(rows_) * cols_, Cell());
+  back_ = front_;
+  front_valid_.assign(rows_, false);
+  dirty_.assign(rows_, true);
+}
+
+void AnsiBackend::drawRow(int row, const RenderRow &content)
+{
+  resizeBuffers(rows(), cols());
+  if (row < 0 || row >= rows_)
+    return;
+
+  Cell *cells = &back_[static_cast<size_t>(row) * cols_];
+  int col = 0;
+  size_t offset = 0;
+  for (const auto &run : content.runs)
+  {
+    for (int i = 0; i < run.length && col < cols_; i++, col++)
+    {
+      cells[col].ch = content.text[offset + i];
+      cells[col].color_pair = static_cast<int16_t>(run.colorPair);
+      cells[col].flags = run.flags;
+    }
+    offset += run.length;
+  }
+  std::fill(cells + col, cells + cols_, Cell());
+  dirty_[row] = true;
+}
+
+void AnsiBackend::moveCursor(int row, int col)
+{
+  cursor_row_ = row;
+  cursor_col_ = col;
+}
+
+bool AnsiBackend::scrollRows(int top, int bottom, int count)
+{
+  resizeBuffers(rows(), cols());
+  if (!validScroll(top, bottom, count, rows_))
+    return false;
+
+  // Both buffers move with the terminal. Exposed rows are blank in whatever
+  // background the terminal erases with, so they are written in full.
+  shiftRows(front_, cols_, top, bottom, count, Cell());
+  shiftRows(back_, cols_, top, bottom, count, Cell());
+  shiftRows(front_valid_, 1, top, bottom, count, false);
+  shiftRows(dirty_, 1, top, bottom, count, true);
+  scrolls_ += scrollSequence(top, bottom, count);
+  return true;
+}
+
+void AnsiBackend::invalidate()
+{
+  std::fill(front_valid_.begin(), front_valid_.end(), false);
+  std::fill(dirty_.begin(), dirty_.end(), true);
+  scrolls_.clear();
+}
+
+void AnsiBackend::flush()
+{
+  // Let curses send its own pending output first (the clear after a resize
+  // or theme reload), so it cannot land on top of this frame. stdscr itself
+  // is never drawn into.
+  wnoutrefresh(stdscr);
+  doupdate();
+
+  resizeBuffers(rows(), cols());
+
+  // Scroll regions home the cursor, so positions start out unknown
+  out_.swap(scrolls_);
+  scrolls_.clear();
+  out_row_ = -1;
+  out_col_ = -1;
+  style_known_ = false;
+
+  for (int row = 0; row < rows_; row++)
+  {
+    if (dirty_[row])
+    {
+      emitRow(row);
+      dirty_[row] = false;
+    }
+  }
+
+  if (cursor_row_ >= 0 && cursor_row_ < rows_ && cursor_col_ >= 0 &&
+      cursor_col_ < cols_)
+  {
+    emitMove(cursor_row_, cursor_col_);
+  }
+  if (style_known_)
+    out_ += "\x1b[0m";
+
+  writeOut();
+}
+
+void AnsiBackend::emitRow(int row)
+{
+  Cell *back = &back_[static_cast<size_t>(row) * cols_];
+  Cell *front = &front_[static_cast<size_t>(row) * cols_];
+
+  if (!front_valid_[row])
+  {
+    // Unknown contents: write up to the trailing blanks, erase the rest
+    int end = cols_;
+    while (end > 0 && back[end - 1] == Cell())
+      end--;
+
+    emitMove(row, 0);
+    for (int col = 0; col < end; col++)
+    {
+      emitCell(back[col]);
+    }
+    if (end < cols_)
+    {
+      emitStyle(Cell()); // Erased cells take the current background
+      out_ += "\x1b[K";
+    }
+
+    std::copy(back, back + cols_, front);
+    front_valid_[row] = true;
+    return;
+  }
+
+  int col = 0;
+  while (col < cols_)
+  {
+    if (back[col] == front[col])
+    {
+      col++;
+      continue;
+    }
+
+    // Extend over changed cells; a short unchanged gap is cheaper to
+    // rewrite than to jump over with a cursor move
+    int end = col + 1;
+    int gap = 0;
+    for (int c = col + 1; c < cols_; c++)
+    {
+      if (back[c] != front[c])
+      {
+        end = c + 1;
+        gap = 0;
+      }
+      else if (++gap > 4)
+      {
+        break;
+      }
+    }
+
+    emitMove(row, col);
+    for (int c = col; c < end; c++)
+    {
+      emitCell(back[c]);
+    }
+    col = end;
+  }
+
+  std::copy(back, back + cols_, front);
+}
+
+void AnsiBackend::emitMove(int row, int col)
+{
+  if (out_row_ == row && out_col_ == col)
+    return;
+
+  out_ += "\x1b[";
+  out_ += std::to_string(row + 1);
+  out_ += ';';
+  out_ += std::to_string(col + 1);
+  out_ += 'H';
+  out_row_ = row;
+  out_col_ = col;
+}
+
+void AnsiBackend::emitStyle(const Cell &cell)
+{
+  if (!style_known_ || cell.color_pair != style_.color_pair ||
+      cell.flags != style_.flags)
+  {
+    std::string sgr = "\x1b[0";
+    if (cell.flags & STYLE_BOLD)
+      sgr += ";1";
+    if (cell.flags & STYLE_DIM)
+      sgr += ";2";
+    if (cell.flags & STYLE_ITALIC)
+      sgr += ";3";
+    if (cell.flags & STYLE_UNDERLINE)
+      sgr += ";4";
+    if (cell.flags & STYLE_REVERSE)
+      sgr += ";7";
+    sgr += ';';
+    sgr += g_style_manager.get_pair_sgr(cell.color_pair);
+    sgr += 'm';
+
+    if (!style_known_ || sgr != sgr_)
+    {
+      out_ += sgr;
+      sgr_ = std::move(sgr);
+    }
+    style_ = cell;
+    style_known_ = true;
+  }
+}
+
+void AnsiBackend::emitCell(const Cell &cell)
+{
+  emitStyle(cell);
+  out_ += cell.ch;
+  // Past the last column the terminal may hold a pending wrap
+  if (out_col_ >= 0 && ++out_col_ >= cols_)
+    out_row_ = out_col_ = -1;
+}
+
+void AnsiBackend::writeOut()
+{
+  if (out_.empty())
+    return;
+
+#ifdef _WIN32
+  fwrite(out_.data(), 1, out_.size(), stdout);
+  fflush(stdout);
+#else
+  const char *data = out_.data();
+  size_t remaining = out_.size();
+  while (remaining > 0)
+  {
+    ssize_t written = write(fd_, data, remaining);
+    if (written < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      break; // Terminal gone; nothing sensible left to do
+    }
+    data += written;
+    remaining -= written;
+  }
+#endif
+
+  bytes_written_ += out_.size();
+}
@@ -0,0 +1,186 @@
+// src/ui/render_backend.h
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Text attributes of a run, independent of the terminal library
+enum StyleFlags : uint16_t
+{
+  STYLE_NONE = 0,
+  STYLE_BOLD = 1 << 0,
+  STYLE_DIM = 1 << 1,
+  STYLE_UNDERLINE = 1 << 2,
+  STYLE_REVERSE = 1 << 3,
+  STYLE_ITALIC = 1 << 4,
+};
+
+// `length` characters drawn with one color pair (see ColorPairs) and flags
+struct StyleRun
+{
+  int colorPair = 0;
+  uint16_t flags = STYLE_NONE;
+  int length = 0;
+
+  bool sameStyle(const StyleRun &other) const
+  {
+    return colorPair == other.colorPair && flags == other.flags;
+  }
+};
+
+// One screen row as built by the Renderer. The runs cover `text` exactly;
+// cells past its end are blank in the default color.
+struct RenderRow
+{
+  std::string text;
+  std::vector<StyleRun> runs;
+};
+
+// Where a frame ends up. The Renderer decides which rows changed; a backend
+// only writes what it is given.
+class RenderBackend
+{
+public:
+  virtual ~RenderBackend() = default;
+
+  virtual int rows() const = 0;
+  virtual int cols() const = 0;
+
+  // Replace screen row `row` with `content`
+  virtual void drawRow(int row, const RenderRow &content) = 0;
+  virtual void moveCursor(int row, int col) = 0;
+  // Shift rows top..bottom up by `count` (down if negative); the rows this
+  // exposes are drawn next. Returns false when not supported, in which case
+  // the caller redraws the moved rows instead.
+  virtual bool scrollRows(int /*top*/, int /*bottom*/, int /*count*/)
+  {
+    return false;
+  }
+  // Send everything drawn since the last flush to the terminal
+  virtual void flush() {}
+  // The terminal was cleared; forget what it shows
+  virtual void invalidate() {}
+};
+
+// Draws into stdscr
+class CursesBackend : public RenderBackend
+{
+public:
+  int rows() const override;
+  int cols() const override;
+  void drawRow(int row, const RenderRow &content) override;
+  void moveCursor(int row, int col) override;
+  bool scrollRows(int top, int bottom, int count) override;
+  void flush() override;
+};
+
+// Writes frames itself with 24-bit SGR colors taken from the theme, so
+// colors do not depend on the curses palette. Curses still reads input and
+// tracks the screen size.
+//
+// drawRow() fills a back buffer of cells; flush() diffs it against the
+// front buffer (what the terminal shows) and sends only changed cells, with
+// cursor moves and SGR changes as needed, in a single write. scrollRows()
+// shifts both buffers and queues a DECSTBM scroll region with SU/SD.
+class AnsiBackend : public RenderBackend
+{
+public:
+  explicit AnsiBackend(int fd = 1);
+
+  int rows() const override;
+  int cols() const override;
+  void drawRow(int row, const RenderRow &content) override;
+  void moveCursor(int row, int col) override;
+  bool scrollRows(int top, int bottom, int count) override;
+  void flush() override;
+  void invalidate() override;
+
+  uint64_t bytesWritten() const { return bytes_written_; }
+
+private:
+  struct Cell
+  {
+    char ch = ' ';
+    int16_t color_pair = 0;
+    uint16_t flags = STYLE_NONE;
+
+    bool operator==(const Cell &other) const
+    {
+      return ch == other.ch && color_pair == other.color_pair &&
+             flags == other.flags;
+    }
+    bool operator!=(const Cell &other) const { return !(*this == other); }
+  };
+
+  void resizeBuffers(int rows, int cols);
+  void emitRow(int row);
+  void emitMove(int row, int col);
+  void emitStyle(const Cell &cell);
+  void emitCell(const Cell &cell);
+  void writeOut();
+
+  int fd_;
+  int rows_ = 0;
+  int cols_ = 0;
+  std::vector<Cell> front_;
+  std::vector<Cell> back_;
+  std::vector<bool> front_valid_; // Per row: front_ matches the terminal
+  std::vector<bool> dirty_;       // Per row: back_ changed since flush
+
+  int cursor_row_ = 0;
+  int cursor_col_ = 0;
+
+  // Output state while building a frame
+  std::string out_;
+  std::string scrolls_; // Scrolls since the last flush, sent before rows
+  int out_row_ = -1; // Terminal cursor position, -1 if unknown
+  int out_col_ = -1;
+  bool style_known_ = false;
+  Cell style_;      // Style of the last cell written (ch unused)
+  std::string sgr_; // Last SGR sent; pairs may share colors
+  uint64_t bytes_written_ = 0;
+};
+
+// In-memory screen of a fixed size, for benchmarks and tests that have no
+// terminal. Counts what a real terminal would have been sent.
+class HeadlessBackend : public RenderBackend
+{
+public:
+  struct Stats
+  {
+    uint64_t rows = 0;    // drawRow() calls
+    uint64_t cells = 0;   // Characters written
+    uint64_t runs = 0;    // Attribute changes
+    uint64_t scrolls = 0; // scrollRows() calls
+    // Size of the equivalent VT100 stream: a cursor move per row, an SGR per
+    // run (color pairs sized as 256-color indices), the text, and an erase
+    // for rows shorter than the screen. A scroll is a scroll region, a
+    // scroll by n and a region reset.
+    uint64_t bytes = 0;
+  };
+
+  HeadlessBackend(int rows, int cols);
+
+  void resize(int rows, int cols);
+  int rows() const override { return rows_; }
+  int cols() const override { return cols_; }
+  void drawRow(int row, const RenderRow &content) override;
+  void moveCursor(int row, int col) override;
+  bool scrollRows(int top, int bottom, int count) override;
+
+  const std::string &rowText(int row) const { return screen_[row]; }
+  int cursorRow() const { return cursor_row_; }
+  int cursorCol() const { return cursor_col_; }
+
+  const Stats &stats() const { return stats_; }
+  void resetStats() { stats_ = Stats(); }
+
+private:
+  int rows_;
+  int cols_;
+  std::vector<std::string> screen_;
+  int cursor_row_ = 0;
+  int cursor_col_ = 0;
+  Stats stats_;
+};
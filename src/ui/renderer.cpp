@@ -1,441 +1,467 @@
 #include "renderer.h"
 #include "src/ui/style_manager.h"
 #include <algorithm>
+#include <cstdio>
 #include <cstring>
+#include <functional>
 #include <iostream>
 
-Renderer::Renderer() : tab_size_(4) {}
+namespace
+{
+// FNV-1a over the values that decide what a screen row looks like
+void hashValue(uint64_t &hash, uint64_t value)
+{
+  for (int i = 0; i < 8; i++)
+  {
+    hash ^= (value >> (i * 8)) & 0xff;
+    hash *= 1099511628211ull;
+  }
+}
 
-Renderer::~Renderer() { restoreDefaultCursor(); }
+uint64_t hashRow(const RenderRow &row)
+{
+  uint64_t hash = 14695981039346656037ull;
+  hashValue(hash, std::hash<std::string>{}(row.text));
+  for (const auto &run : row.runs)
+  {
+    hashValue(hash, (uint64_t(uint32_t(run.colorPair)) << 32) |
+                        (uint64_t(run.flags) << 16) |
+                        uint16_t(run.length));
+  }
+  return hash | 1; // 0 means "unknown"
+}
 
-void Renderer::renderEditor(const EditorState &state, const GapBuffer &buffer,
-                            const SyntaxHighlighter *highlighter)
+// ColorSpan attributes are curses A_* values
+uint16_t styleFlags(int attribute)
 {
-  // Set background color for entire screen
-  setDefaultColors();
-  clear();
+  uint16_t flags = STYLE_NONE;
+  if (attribute & A_BOLD)
+    flags |= STYLE_BOLD;
+  if (attribute & A_DIM)
+    flags |= STYLE_DIM;
+  if (attribute & A_UNDERLINE)
+    flags |= STYLE_UNDERLINE;
+  if (attribute & A_REVERSE)
+    flags |= STYLE_REVERSE;
+#ifdef A_ITALIC
+  if (attribute & A_ITALIC)
+    flags |= STYLE_ITALIC;
+#endif
+  return flags;
+}
 
-  // Render main content area
-  renderContent(state, buffer, highlighter);
+void addRun(RenderRow &row, int color_pair, uint16_t flags, int length)
+{
+  if (length <= 0)
+    return;
+  StyleRun run{color_pair, flags, length};
+  if (!row.runs.empty() && row.runs.back().sameStyle(run))
+    row.runs.back().length += length;
+  else
+    row.runs.push_back(run);
+}
 
-  // Render status bar
-  renderStatusBar(state, buffer);
+const uint64_t EMPTY_ROW_HASH = 3;
+} // namespace
 
-  // Position cursor
-  positionCursor(state.cursor, state.viewport);
+Renderer::Renderer() : backend_(std::make_unique<CursesBackend>()) {}
 
-  // Update cursor style based on mode
-  updateCursorStyle(state.mode);
+Renderer::Renderer(std::unique_ptr<RenderBackend> backend)
+    : backend_(std::move(backend))
+{
+}
 
-  refresh();
+void Renderer::setBackend(std::unique_ptr<RenderBackend> backend)
+{
+  backend_ = std::move(backend);
+  invalidate();
 }
 
-void Renderer::renderContent(const EditorState &state, const GapBuffer &buffer,
-                             const SyntaxHighlighter *highlighter)
+int Renderer::render(const FrameState &state, const GapBuffer &buffer,
+                     const SyntaxHighlighter *highlighter)
 {
-  const ViewportInfo &viewport = state.viewport;
+  buildFrame(state, buffer, highlighter, frame_);
+  int emitted = present(frame_);
+  positionCursor(state);
+  return emitted;
+}
 
-  int line_num_width = calculateLineNumberWidth(buffer.getLineCount());
-  int end_line =
-      std::min(viewport.top + viewport.height, buffer.getLineCount());
+void Renderer::buildFrame(const FrameState &state, const GapBuffer &buffer,
+                          const SyntaxHighlighter *highlighter, Frame &frame)
+{
+  static const auto empty_row = std::make_shared<const RenderRow>();
 
-  // Pre-calculate syntax highlighting for visible lines
-  std::vector<std::vector<ColorSpan>> line_spans(end_line - viewport.top);
-  if (highlighter)
+  const ViewportInfo &viewport = state.viewport;
+  int height = std::max(0, viewport.height);
+  frame.rows.assign(height + 1, empty_row);
+  frame.hashes.assign(height + 1, EMPTY_ROW_HASH);
+
+  int end_line = std::min(viewport.top + height, state.line_count);
+  for (int i = viewport.top; i < end_line; i++)
   {
-    for (int i = viewport.top; i < end_line; i++)
+    std::string expanded_line = expandTabs(buffer.getLine(i), state.tab_size);
+
+    std::vector<ColorSpan> spans;
+    if (highlighter)
     {
       try
       {
-        std::string line = buffer.getLine(i);
-        std::string expanded_line = expandTabs(line, tab_size_);
-        line_spans[i - viewport.top] =
-            highlighter->getHighlightSpans(expanded_line, i, buffer);
+        spans = highlighter->getHighlightSpans(expanded_line, i, buffer);
       }
       catch (const std::exception &e)
       {
         std::cerr << "Syntax highlighting error on line " << i << ": "
                   << e.what() << std::endl;
-        line_spans[i - viewport.top].clear();
+        spans.clear();
       }
     }
-  }
 
-  // Render each visible line
-  for (int i = viewport.top; i < end_line; i++)
-  {
-    int screen_row = i - viewport.top;
-    move(screen_row, 0);
+    // Selected columns [sel_from, sel_to) of this line, if any
+    int sel_from = -1;
+    int sel_to = -1;
+    int length = static_cast<int>(expanded_line.length());
+    if (state.has_selection && i >= state.selection_start_line &&
+        i <= state.selection_end_line)
+    {
+      sel_from = i == state.selection_start_line ? state.selection_start_col : 0;
+      sel_to = i == state.selection_end_line ? state.selection_end_col : length;
+      sel_to = std::min(sel_to, length);
+      if (sel_from >= sel_to)
+        sel_from = sel_to = -1;
+    }
 
-    // Set background for entire line
-    setDefaultColors();
+    // Hash the inputs rather than the built row, so unchanged rows are
+    // never built
+    uint64_t hash = 14695981039346656037ull;
+    hashValue(hash, std::hash<std::string>{}(expanded_line));
+    for (const auto &span : spans)
+    {
+      hashValue(hash,
+                (uint64_t(uint32_t(span.start)) << 32) | uint32_t(span.end));
+      hashValue(hash, (uint64_t(uint32_t(span.colorPair)) << 32) |
+                          uint32_t(span.attribute));
+    }
+    hashValue(hash, (uint64_t(uint32_t(sel_from)) << 32) | uint32_t(sel_to));
+    hashValue(hash, (uint64_t(uint32_t(viewport.left)) << 32) |
+                        uint32_t(viewport.width));
+    if (state.show_line_numbers)
+    {
+      // The gutter only changes the row when it is shown
+      hashValue(hash, (uint64_t(uint32_t(i)) << 32) |
+                          (uint32_t(state.line_num_width) << 1) |
+                          (state.cursor.line == i));
+    }
+    hash |= 1;
 
-    // Render line number
-    bool is_current_line = (state.cursor.line == i);
-    renderLineNumbers(i, i + 1, state.cursor.line, line_num_width,
-                      viewport.top);
+    auto cached = row_cache_.find(hash);
+    if (cached == row_cache_.end())
+    {
+      if (row_cache_.size() >= ROW_CACHE_LIMIT)
+        row_cache_.clear();
+      cached = row_cache_
+                   .emplace(hash, std::make_shared<const RenderRow>(renderLine(
+                                      expanded_line, i, spans, sel_from,
+                                      sel_to, state)))
+                   .first;
+    }
 
-    // Render line content
-    std::string line = buffer.getLine(i);
-    std::string expanded_line = expandTabs(line, tab_size_);
-    const std::vector<ColorSpan> &spans =
-        highlighter ? line_spans[i - viewport.top] : std::vector<ColorSpan>();
+    frame.rows[i - viewport.top] = cached->second;
+    frame.hashes[i - viewport.top] = hash;
+  }
+
+  auto status = std::make_shared<const RenderRow>(renderStatusBar(state));
+  frame.hashes[height] = hashRow(*status);
+  frame.rows[height] = std::move(status);
+}
+
+int Renderer::present(const Frame &frame)
+{
+  if (presented_.size() != frame.hashes.size())
+    presented_.assign(frame.hashes.size(), 0);
+
+  // When the text rows moved up or down as a block (scrolling, or lines
+  // inserted/deleted above the bottom), let the terminal shift them so only
+  // the rows it exposes are drawn. The status bar row stays put.
+  int text_rows = static_cast<int>(frame.hashes.size()) - 1;
+  int shift = findShift(frame.hashes, text_rows);
+  if (shift != 0 && backend_->scrollRows(0, text_rows - 1, shift))
+  {
+    if (shift > 0)
+    {
+      std::copy(presented_.begin() + shift, presented_.begin() + text_rows,
+                presented_.begin());
+      std::fill(presented_.begin() + text_rows - shift,
+                presented_.begin() + text_rows, 0);
+    }
+    else
+    {
+      std::copy_backward(presented_.begin(),
+                         presented_.begin() + text_rows + shift,
+                         presented_.begin() + text_rows);
+      std::fill(presented_.begin(), presented_.begin() - shift, 0);
+    }
+  }
 
-    renderLine(expanded_line, i, spans, viewport, state);
+  // Rows that look the same as last frame are not touched at all
+  int emitted = 0;
+  for (size_t row = 0; row < frame.rows.size(); row++)
+  {
+    if (presented_[row] == frame.hashes[row])
+      continue;
 
-    // Clear to end of line with proper background
-    setDefaultColors();
-    clrtoeol();
+    backend_->drawRow(static_cast<int>(row), *frame.rows[row]);
+    presented_[row] = frame.hashes[row];
+    emitted++;
   }
+  return emitted;
+}
 
-  // Fill remaining screen with background color
-  setDefaultColors();
-  for (int i = end_line - viewport.top; i < viewport.height; i++)
+int Renderer::findShift(const std::vector<uint64_t> &hashes,
+                        int text_rows) const
+{
+  // Net rows saved by shifting by `shift` (new row r shows old row
+  // r + shift): rows that would otherwise be redrawn, minus rows that are
+  // already right where they are and would be moved away
+  int best_shift = 0;
+  int best_gain = MIN_SCROLL_GAIN - 1;
+  for (int shift = 1 - text_rows; shift < text_rows; shift++)
   {
-    move(i, 0);
-    clrtoeol();
+    if (shift == 0)
+      continue;
+
+    int gain = 0;
+    int first = std::max(0, -shift);
+    int last = std::min(text_rows, text_rows - shift);
+    for (int row = first; row < last; row++)
+    {
+      uint64_t old_row = presented_[row + shift];
+      if (old_row == 0)
+        continue;
+      bool in_place = presented_[row] == hashes[row];
+      bool shifted = old_row == hashes[row];
+      gain += shifted && !in_place;
+      gain -= in_place && !shifted;
+    }
+
+    if (gain > best_gain)
+    {
+      best_gain = gain;
+      best_shift = shift;
+    }
   }
+  return best_shift;
 }
 
-void Renderer::renderLine(const std::string &line, int line_number,
-                          const std::vector<ColorSpan> &spans,
-                          const ViewportInfo &viewport,
-                          const EditorState &state)
+RenderRow Renderer::renderLine(const std::string &line, int line_number,
+                               const std::vector<ColorSpan> &spans,
+                               int sel_from, int sel_to,
+                               const FrameState &state) const
 {
-  int content_width = viewport.width - viewport.content_start_col;
+  const ViewportInfo &viewport = state.viewport;
+  RenderRow row;
 
-  for (int screen_col = 0; screen_col < content_width; screen_col++)
+  // Render line numbers
+  if (state.show_line_numbers)
   {
-    int file_col = viewport.left + screen_col;
-
-    bool char_exists =
-        (file_col >= 0 && file_col < static_cast<int>(line.length()));
-    char ch = char_exists ? line[file_col] : ' ';
+    int color_pair = (state.cursor.line == line_number) ? LINE_NUMBERS_ACTIVE
+                                                        : LINE_NUMBERS;
+    char number[32];
+    int written = snprintf(number, sizeof(number), "%*d ",
+                           state.line_num_width, line_number + 1);
+    row.text.append(number);
+    addRun(row, color_pair, STYLE_NONE, written);
+
+    // Separator
+    row.text.append("  ");
+    addRun(row, LINE_NUMBERS_DIM, STYLE_NONE, 1);
+    addRun(row, DEFAULT_PAIR, STYLE_NONE, 1);
+  }
 
-    // Filter non-printable characters
-    if (char_exists && (ch < 32 || ch > 126))
+  // Visible slice of the line, padded to the content width
+  int length = static_cast<int>(line.length());
+  int left = viewport.left;
+  int right =
+      viewport.left + std::max(0, viewport.width - viewport.content_start_col);
+  if (left < length)
+    row.text.append(line, left, std::min(right, length) - left);
+  row.text.append(right - std::max(left, std::min(right, length)), ' ');
+
+  // Walk attribute boundaries (selection edges, span edges, end of text)
+  // instead of individual cells
+  int current_span_idx = 0;
+  int num_spans = spans.size();
+  int col = left;
+  while (col < right)
+  {
+    if (col >= length)
     {
-      ch = ' ';
+      addRun(row, DEFAULT_PAIR, STYLE_NONE, right - col);
+      break;
     }
 
-    // Check for selection
-    bool is_selected = isPositionSelected(line_number, file_col, state);
+    int next = std::min(right, length);
+    int color_pair = DEFAULT_PAIR;
+    uint16_t flags = STYLE_NONE;
 
-    if (is_selected)
+    if (col >= sel_from && col < sel_to)
     {
-      attron(COLOR_PAIR(SELECTION) | A_REVERSE);
-      addch(ch);
-      attroff(COLOR_PAIR(SELECTION) | A_REVERSE);
+      color_pair = SELECTION;
+      flags = STYLE_REVERSE;
+      next = std::min(next, sel_to);
     }
     else
     {
-      // Apply syntax highlighting
-      bool color_applied = false;
+      if (sel_from > col)
+        next = std::min(next, sel_from);
 
-      if (char_exists && !spans.empty())
+      while (current_span_idx < num_spans &&
+             spans[current_span_idx].end <= col)
       {
-        for (const auto &span : spans)
+        current_span_idx++;
+      }
+
+      if (current_span_idx < num_spans)
+      {
+        const auto &span = spans[current_span_idx];
+        if (col >= span.start)
         {
-          if (file_col >= span.start && file_col < span.end)
+          next = std::min(next, span.end);
+          if (span.colorPair >= 0)
           {
-            if (span.colorPair >= 0 && span.colorPair < COLOR_PAIRS)
-            {
-              applyColorSpan(span, ch);
-              color_applied = true;
-              break;
-            }
+            color_pair = span.colorPair;
+            flags = styleFlags(span.attribute);
           }
         }
-      }
-
-      if (!color_applied)
-      {
-        setDefaultColors();
-        addch(ch);
+        else
+        {
+          next = std::min(next, span.start);
+        }
       }
     }
-  }
-}
 
-void Renderer::renderStatusBar(const EditorState &state,
-                               const GapBuffer &buffer)
-{
-  int rows, cols;
-  getmaxyx(stdscr, rows, cols);
-  int status_row = rows - 1;
-
-  move(status_row, 0);
-
-  // Set status bar background
-  attrset(COLOR_PAIR(STATUS_BAR));
-  clrtoeol();
-
-  move(status_row, 0);
-
-  // Render mode
-  renderStatusMode(state.mode);
-
-  // Render file info
-  renderStatusFile(state.filename, state.is_modified);
+    addRun(row, color_pair, flags, next - col);
+    col = next;
+  }
 
-  // Render position info (right-aligned)
-  renderStatusPosition(state.cursor, buffer.getLineCount(), state.has_selection,
-                       0); // TODO: calculate selection size
+  return row;
 }
 
-void Renderer::renderStatusMode(EditorMode mode)
+RenderRow Renderer::renderStatusBar(const FrameState &state) const
 {
-  std::string mode_str;
-  int mode_color;
-
-  switch (mode)
+  int cols = state.viewport.width;
+  RenderRow row;
+  auto append = [&row](const std::string &text, int color_pair,
+                       uint16_t flags)
   {
-  case EditorMode::NORMAL:
-    mode_str = " NORMAL ";
-    mode_color = STATUS_BAR;
-    break;
-  case EditorMode::INSERT:
-    mode_str = " INSERT ";
-    mode_color = STATUS_BAR_ACTIVE;
-    break;
-  case EditorMode::VISUAL:
-    mode_str = " VISUAL ";
-    mode_color = STATUS_BAR_ACTIVE;
-    break;
-  }
+    row.text += text;
+    addRun(row, color_pair, flags, static_cast<int>(text.length()));
+  };
 
-  attron(COLOR_PAIR(mode_color) | A_BOLD);
-  printw("%s", mode_str.c_str());
-  attroff(COLOR_PAIR(mode_color) | A_BOLD);
-
-  attron(COLOR_PAIR(STATUS_BAR));
-  printw(" ");
-}
-
-void Renderer::renderStatusFile(const std::string &filename, bool is_modified)
-{
-  attron(COLOR_PAIR(STATUS_BAR_CYAN) | A_BOLD);
-  if (filename.empty())
+  // Show filename
+  if (state.filename.empty())
   {
-    printw("[No Name]");
+    append("[No Name]", STATUS_BAR_CYAN, STYLE_BOLD);
   }
   else
   {
-    size_t last_slash = filename.find_last_of("/\\");
-    std::string display_name = (last_slash != std::string::npos)
-                                   ? filename.substr(last_slash + 1)
-                                   : filename;
-    printw("%s", display_name.c_str());
+    size_t last_slash = state.filename.find_last_of("/\\");
+    append(last_slash != std::string::npos
+               ? state.filename.substr(last_slash + 1)
+               : state.filename,
+           STATUS_BAR_CYAN, STYLE_BOLD);
   }
-  attroff(COLOR_PAIR(STATUS_BAR_CYAN) | A_BOLD);
 
-  if (is_modified)
-  {
-    attron(COLOR_PAIR(STATUS_BAR_ACTIVE) | A_BOLD);
-    printw(" [+]");
-    attroff(COLOR_PAIR(STATUS_BAR_ACTIVE) | A_BOLD);
-  }
-}
+  // Show modified indicator
+  if (state.is_modified)
+    append(" [+]", STATUS_BAR_ACTIVE, STYLE_BOLD);
 
-void Renderer::renderStatusPosition(const CursorInfo &cursor, int total_lines,
-                                    bool has_selection, int selection_size)
-{
-  int rows, cols;
-  getmaxyx(stdscr, rows, cols);
-  int status_row = rows - 1;
+  // Show file extension
+  if (!state.extension.empty())
+    append(" [" + state.extension + "]", STATUS_BAR_ACTIVE, STYLE_NONE);
 
-  char position_info[256];
+  // Right section with position info
+  const CursorInfo &cursor = state.cursor;
+  int total_lines = state.line_count;
   int percentage =
       total_lines == 0 ? 0 : ((cursor.line + 1) * 100 / total_lines);
 
-  if (has_selection)
+  char right_section[256];
+  if (state.show_selection_size &&
+      state.selection_start_line == state.selection_end_line)
+  {
+    snprintf(right_section, sizeof(right_section),
+             "[%d chars] %d:%d %d/%d %d%% ",
+             state.selection_end_col - state.selection_start_col,
+             cursor.line + 1, cursor.col + 1, cursor.line + 1, total_lines,
+             percentage);
+  }
+  else if (state.show_selection_size)
   {
-    snprintf(position_info, sizeof(position_info),
-             "[selection] %d:%d %d/%d %d%% ", cursor.line + 1, cursor.col + 1,
-             cursor.line + 1, total_lines, percentage);
+    snprintf(right_section, sizeof(right_section),
+             "[%d lines] %d:%d %d/%d %d%% ",
+             state.selection_end_line - state.selection_start_line + 1,
+             cursor.line + 1, cursor.col + 1, cursor.line + 1, total_lines,
+             percentage);
   }
   else
   {
-    snprintf(position_info, sizeof(position_info), "%d:%d %d/%d %d%% ",
+    snprintf(right_section, sizeof(right_section), "%d:%d %d/%d %d%% ",
              cursor.line + 1, cursor.col + 1, cursor.line + 1, total_lines,
              percentage);
   }
 
-  int info_len = strlen(position_info);
-  int current_pos = getcurx(stdscr);
-  int right_start = cols - info_len;
+  int right_len = strlen(right_section);
+  int current_pos = static_cast<int>(row.text.length());
+  int right_start = cols - right_len;
 
   if (right_start <= current_pos)
   {
     right_start = current_pos + 2;
   }
 
-  // Fill middle space
-  attron(COLOR_PAIR(STATUS_BAR));
-  for (int i = current_pos; i < right_start && i < cols; i++)
-  {
-    move(status_row, i);
-    addch(' ');
-  }
+  // Fill middle space, then the right section
+  append(std::string(std::max(0, right_start - current_pos), ' '), STATUS_BAR,
+         STYLE_NONE);
+  append(right_section, STATUS_BAR_YELLOW, STYLE_BOLD);
 
-  // Render position info
-  if (right_start < cols)
+  // Clip to the screen width
+  int excess = static_cast<int>(row.text.length()) - std::max(0, cols);
+  if (excess > 0)
   {
-    move(status_row, right_start);
-    attron(COLOR_PAIR(STATUS_BAR_YELLOW) | A_BOLD);
-    printw("%s", position_info);
-    attroff(COLOR_PAIR(STATUS_BAR_YELLOW) | A_BOLD);
+    row.text.resize(std::max(0, cols));
+    while (excess > 0 && !row.runs.empty())
+    {
+      int cut = std::min(excess, row.runs.back().length);
+      row.runs.back().length -= cut;
+      excess -= cut;
+      if (row.runs.back().length == 0)
+        row.runs.pop_back();
+    }
   }
-}
 
-void Renderer::renderLineNumbers(int start_line, int end_line, int current_line,
-                                 int line_num_width, int viewport_top)
-{
-  int line_index = start_line - viewport_top;
-  bool is_current = (start_line == current_line);
-
-  int color_pair = is_current ? LINE_NUMBERS_ACTIVE : LINE_NUMBERS;
-  attron(COLOR_PAIR(color_pair));
-  printw("%*d ", line_num_width, start_line + 1);
-  attroff(COLOR_PAIR(color_pair));
-
-  // Separator
-  attron(COLOR_PAIR(LINE_NUMBERS_DIM));
-  addch(' ');
-  attroff(COLOR_PAIR(LINE_NUMBERS_DIM));
-  addch(' ');
+  return row;
 }
 
-void Renderer::positionCursor(const CursorInfo &cursor,
-                              const ViewportInfo &viewport)
+void Renderer::positionCursor(const FrameState &state)
 {
-  int screen_row = cursor.line - viewport.top;
+  const ViewportInfo &viewport = state.viewport;
+  int screen_row = state.cursor.line - viewport.top;
   if (screen_row >= 0 && screen_row < viewport.height)
   {
-    int screen_col = viewport.content_start_col + cursor.col - viewport.left;
-
-    int rows, cols;
-    getmaxyx(stdscr, rows, cols);
+    int screen_col =
+        viewport.content_start_col + state.cursor.col - viewport.left;
 
-    if (screen_col >= viewport.content_start_col && screen_col < cols)
+    if (screen_col >= viewport.content_start_col && screen_col < viewport.width)
     {
-      move(screen_row, screen_col);
+      backend_->moveCursor(screen_row, screen_col);
     }
     else
     {
-      move(screen_row, viewport.content_start_col);
+      backend_->moveCursor(screen_row, viewport.content_start_col);
     }
   }
 }
 
-void Renderer::updateCursorStyle(EditorMode mode)
-{
-  switch (mode)
-  {
-  case EditorMode::NORMAL:
-    printf("\033[2 q"); // Block cursor
-    break;
-  case EditorMode::INSERT:
-    printf("\033[6 q"); // Vertical bar cursor
-    break;
-  case EditorMode::VISUAL:
-    printf("\033[4 q"); // Underline cursor
-    break;
-  }
-  fflush(stdout);
-}
-
-void Renderer::restoreDefaultCursor()
-{
-  printf("\033[0 q");
-  fflush(stdout);
-}
-
-void Renderer::clear() { ::clear(); }
-
-void Renderer::refresh() { ::refresh(); }
-
-void Renderer::handleResize()
-{
-  clear();
-  refresh();
-}
-
-Renderer::ViewportInfo Renderer::calculateViewport() const
-{
-  ViewportInfo viewport;
-  int rows, cols;
-  getmaxyx(stdscr, rows, cols);
-
-  viewport.height = rows - 1; // Reserve last row for status bar
-  viewport.width = cols;
-
-  // Calculate content start column (after line numbers)
-  int max_lines = 1000; // Reasonable default, should be passed as parameter
-  int line_num_width = calculateLineNumberWidth(max_lines);
-  viewport.content_start_col = line_num_width + 3; // +3 for space and separator
-
-  return viewport;
-}
-
-int Renderer::calculateLineNumberWidth(int max_line) const
-{
-  if (max_line <= 0)
-    return 1;
-
-  int width = 0;
-  int num = max_line;
-  while (num > 0)
-  {
-    width++;
-    num /= 10;
-  }
-  return std::max(width, 3); // Minimum width of 3
-}
-
-bool Renderer::isPositionSelected(int line, int col,
-                                  const EditorState &state) const
-{
-  if (!state.has_selection)
-  {
-    return false;
-  }
-
-  int start_line = state.selection_start_line;
-  int start_col = state.selection_start_col;
-  int end_line = state.selection_end_line;
-  int end_col = state.selection_end_col;
-
-  // Normalize selection
-  if (start_line > end_line || (start_line == end_line && start_col > end_col))
-  {
-    std::swap(start_line, end_line);
-    std::swap(start_col, end_col);
-  }
-
-  if (line < start_line || line > end_line)
-  {
-    return false;
-  }
-
-  if (start_line == end_line)
-  {
-    return col >= start_col && col < end_col;
-  }
-  else if (line == start_line)
-  {
-    return col >= start_col;
-  }
-  else if (line == end_line)
-  {
-    return col < end_col;
-  }
-  else
-  {
-    return true;
-  }
-}
-
 std::string Renderer::expandTabs(const std::string &line, int tab_size) const
 {
   std::string result;
@@ -457,21 +483,3 @@ std::string Renderer::expandTabs(const std::string &line, int tab_size) const
   }
   return result;
 }
-
-void Renderer::applyColorSpan(const ColorSpan &span, char ch)
-{
-  int attrs = COLOR_PAIR(span.colorPair);
-  if (span.attribute != 0)
-  {
-    attrs |= span.attribute;
-  }
-
-  attron(attrs);
-  addch(ch);
-  attroff(attrs);
-}
-
-void Renderer::setDefaultColors()
-{
-  attrset(COLOR_PAIR(0)); // Use default background
-}
\ No newline at end of file
@@ -1,103 +1,119 @@
 #pragma once
 
 #include "src/core/buffer.h"
-#include "src/core/editor.h"
 #include "src/features/syntax_highlighter.h"
+#include "src/ui/render_backend.h"
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
-#ifdef _WIN32
-#include <curses.h>
-#else
-#include <ncurses.h>
-#endif
-
-// Forward declarations
-class Editor;
 struct ColorSpan;
 
 /**
  * Handles all rendering/display logic for the editor
  * Separated from Editor to keep business logic clean
+ *
+ * A frame goes through three steps:
+ *   1. The editor gathers a FrameState (viewport, cursor, selection, file).
+ *   2. buildFrame() turns it into a grid of RenderRows, one per screen row.
+ *      This touches no terminal, so it can be tested and benchmarked alone.
+ *   3. present() hands the rows that differ from the previous frame to the
+ *      RenderBackend, after asking it to scroll rows that only moved.
  */
 class Renderer
 {
 public:
   struct ViewportInfo
   {
-    int top;
-    int left;
-    int height;
-    int width;
-    int content_start_col; // Where content starts after line numbers
+    int top = 0;
+    int left = 0;
+    int height = 0; // Text rows; the status bar is drawn below them
+    int width = 0;
+    int content_start_col = 0; // Where content starts after line numbers
   };
 
   struct CursorInfo
   {
-    int line;
-    int col;
-    int screen_row;
-    int screen_col;
+    int line = 0;
+    int col = 0;
   };
 
-  struct EditorState
+  // Everything a frame depends on besides the buffer and highlighter
+  struct FrameState
   {
     ViewportInfo viewport;
     CursorInfo cursor;
-    EditorMode mode;
-    bool has_selection;
-    int selection_start_line;
-    int selection_start_col;
-    int selection_end_line;
-    int selection_end_col;
+    int line_count = 0;
+    bool show_line_numbers = false;
+    int line_num_width = 0;
+    int tab_size = 4;
+    // Highlighted selection, normalized so start <= end
+    bool has_selection = false;
+    int selection_start_line = -1;
+    int selection_start_col = -1;
+    int selection_end_line = -1;
+    int selection_end_col = -1;
+    bool show_selection_size = false; // Status bar "[n chars]"/"[n lines]"
     std::string filename;
-    bool is_modified;
+    std::string extension;
+    bool is_modified = false;
+  };
+
+  // A built screen: text rows, then the status bar
+  struct Frame
+  {
+    std::vector<std::shared_ptr<const RenderRow>> rows;
+    std::vector<uint64_t> hashes; // Identifies what each row shows
   };
 
   Renderer();
-  ~Renderer();
-
-  // Main rendering functions
-  void renderEditor(const EditorState &state, const GapBuffer &buffer,
-                    const SyntaxHighlighter *highlighter);
-
-  // Individual component rendering
-  void renderContent(const EditorState &state, const GapBuffer &buffer,
-                     const SyntaxHighlighter *highlighter);
-  void renderStatusBar(const EditorState &state, const GapBuffer &buffer);
-  void renderLineNumbers(int start_line, int end_line, int current_line,
-                         int line_num_width, int viewport_top);
-
-  // Cursor management
-  void positionCursor(const CursorInfo &cursor, const ViewportInfo &viewport);
-  void updateCursorStyle(EditorMode mode);
-  void restoreDefaultCursor();
-
-  // Screen management
-  void clear();
-  void refresh();
-  void handleResize();
-  ViewportInfo calculateViewport() const;
-
-  // Utility functions
-  int calculateLineNumberWidth(int max_line) const;
-  bool isPositionSelected(int line, int col, const EditorState &state) const;
+  explicit Renderer(std::unique_ptr<RenderBackend> backend);
+
+  void setBackend(std::unique_ptr<RenderBackend> backend);
+  RenderBackend &backend() { return *backend_; }
+
+  // Build, present and place the cursor; returns the number of rows emitted
+  int render(const FrameState &state, const GapBuffer &buffer,
+             const SyntaxHighlighter *highlighter);
+
+  void buildFrame(const FrameState &state, const GapBuffer &buffer,
+                  const SyntaxHighlighter *highlighter, Frame &frame);
+  int present(const Frame &frame);
+  void positionCursor(const FrameState &state);
+
+  // The screen was cleared behind our back; the next present() draws all
+  void invalidate()
+  {
+    presented_.clear();
+    backend_->invalidate();
+  }
+
   std::string expandTabs(const std::string &line, int tab_size = 4) const;
 
 private:
-  int tab_size_;
+  std::unique_ptr<RenderBackend> backend_;
+
+  // Hash of each row as last presented (0 = unknown)
+  std::vector<uint64_t> presented_;
+  Frame frame_;
+
+  // Built text rows by hash, so rows scrolled back into view are not rebuilt
+  std::unordered_map<uint64_t, std::shared_ptr<const RenderRow>> row_cache_;
+  static constexpr size_t ROW_CACHE_LIMIT = 1024;
+
+  // A terminal scroll costs about as much as a short row; shift only when
+  // it saves at least this many row redraws
+  static constexpr int MIN_SCROLL_GAIN = 2;
+
+  // Block shift of the text rows from the presented screen to `hashes`
+  // that saves the most redraws; 0 for none
+  int findShift(const std::vector<uint64_t> &hashes, int text_rows) const;
 
   // Internal rendering helpers
-  void renderLine(const std::string &line, int line_number,
-                  const std::vector<ColorSpan> &spans,
-                  const ViewportInfo &viewport, const EditorState &state);
-
-  void renderStatusMode(EditorMode mode);
-  void renderStatusFile(const std::string &filename, bool is_modified);
-  void renderStatusPosition(const CursorInfo &cursor, int total_lines,
-                            bool has_selection, int selection_size);
-
-  // Color/attribute helpers
-  void applyColorSpan(const ColorSpan &span, char ch);
-  void setDefaultColors();
-};
\ No newline at end of file
+  RenderRow renderLine(const std::string &line, int line_number,
+                       const std::vector<ColorSpan> &spans, int sel_from,
+                       int sel_to, const FrameState &state) const;
+  RenderRow renderStatusBar(const FrameState &state) const;
+};
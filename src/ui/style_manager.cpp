@@ -165,6 +165,38 @@ short StyleManager::resolve_theme_color(const std::string &config_value)
   return theme_color_to_ncurses_color(legacy_color);
 }
 
+std::string StyleManager::sgr_color(const std::string &config_value,
+                                    bool background)
+{
+  if (config_value.length() == 7 && config_value[0] == '#')
+  {
+    RGB rgb = parse_hex_color(config_value);
+    return std::string(background ? "48;2;" : "38;2;") +
+           std::to_string(rgb.r) + ";" + std::to_string(rgb.g) + ";" +
+           std::to_string(rgb.b);
+  }
+
+  // Named colors keep their palette index; transparent/default stay default
+  short color = -1;
+  if (!config_value.empty() && config_value != "transparent" &&
+      config_value != "default")
+  {
+    color = theme_color_to_ncurses_color(string_to_theme_color(config_value));
+  }
+  if (color < 0)
+    return background ? "49" : "39";
+  return std::string(background ? "48;5;" : "38;5;") + std::to_string(color);
+}
+
+std::string StyleManager::get_pair_sgr(int pair_id) const
+{
+  std::lock_guard<std::mutex> lock(pair_sgr_mutex);
+  auto it = pair_sgr.find(pair_id);
+  if (it == pair_sgr.end())
+    it = pair_sgr.find(0);
+  return it != pair_sgr.end() ? it->second : "39;49";
+}
+
 // NEW: Hex color parsing utility
 RGB StyleManager::parse_hex_color(const std::string &hex_str) const
 {
@@ -439,9 +471,20 @@ void StyleManager::apply_theme()
   const int BACKGROUND_PAIR_ID = 100;
   init_pair(BACKGROUND_PAIR_ID, terminal_fg, terminal_bg);
 
+  // Built aside and swapped in at the end: a reload runs on the config
+  // watcher thread while the UI thread may be emitting styles
+  std::map<int, std::string> sgr;
+  sgr[0] = sgr_color(current_theme.foreground, false) + ";" +
+           sgr_color(current_theme.background, true);
+  sgr[BACKGROUND_PAIR_ID] = sgr[0];
+
   auto init_pair_enhanced = [&](int pair_id, const std::string &fg_color_str,
                                 const std::string &bg_color_str) -> bool
   {
+    // Recorded even when curses has too few pairs: truecolor output
+    // does not use them
+    sgr[pair_id] =
+        sgr_color(fg_color_str, false) + ";" + sgr_color(bg_color_str, true);
     if (pair_id >= COLOR_PAIRS)
       return false;
     short fg = resolve_theme_color(fg_color_str);
@@ -518,6 +561,11 @@ void StyleManager::apply_theme()
   init_pair_enhanced(70, current_theme.foreground,
                      current_theme.line_highlight);
 
+  {
+    std::lock_guard<std::mutex> lock(pair_sgr_mutex);
+    pair_sgr.swap(sgr);
+  }
+
   bkgdset(' ' | COLOR_PAIR(BACKGROUND_PAIR_ID));
   clear();
   // refresh();
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <map>
+#include <mutex>
 #include <string>
 
 // Platform-specific ncurses includes
@@ -200,6 +201,12 @@ public:
   void optimize_for_wsl();
   bool is_wsl_environment() const;
 
+  // SGR color parameters ("38;2;r;g;b;48;2;r;g;b") for a color pair, taken
+  // from the theme rather than the curses palette; for output that bypasses
+  // curses (see AnsiBackend). Unknown pairs get the default pair's colors.
+  // Returns a copy, since a theme reload may replace the table meanwhile.
+  std::string get_pair_sgr(int pair_id) const;
+
 private:
   bool initialized;
   NamedTheme current_theme;
@@ -209,6 +216,8 @@ private:
   std::map<std::string, short>
       color_cache;            // Maps Hex code to ncurses ID (>= 16)
   short next_custom_color_id; // Starts at 16
+  std::map<int, std::string> pair_sgr; // Filled by apply_theme()
+  mutable std::mutex pair_sgr_mutex;   // Guards pair_sgr
 
   void load_default_theme();
   void apply_theme();
@@ -217,6 +226,7 @@ private:
 
   // New core color resolution function
   short resolve_theme_color(const std::string &config_value);
+  std::string sgr_color(const std::string &config_value, bool background);
 
   // Hex parsing utilities
   RGB parse_hex_color(const std::string &hex_str) const;